@@ -1,10 +1,22 @@
 #include "Canvas.h"
+#include "PngWriter.h"
+#include "TiledExporter.h"
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
-Canvas::Canvas(int width, int height) : width(width), height(height) {
+Canvas::Canvas(int width, int height)
+    : width(width), height(height), gpuHistoryBytes(0), storagePalette({ BLACK })
+    , activeCommands(0), uploadTexture({}) {
     renderTexture = LoadRenderTexture(width, height);
 
+    // Steady-state history operations never grow these
+    undoStack.reserve(MAX_HISTORY + 1);
+    redoStack.reserve(MAX_HISTORY + 1);
+    spareTextures.reserve(MAX_SPARE_TEXTURES);
+    commands.reserve(COMMAND_RESERVE);
+    commandPoints.reserve(POINT_RESERVE);
+
     // Initialize with black background
     BeginTextureMode(renderTexture);
     ClearBackground(BLACK);
@@ -15,12 +27,16 @@ Canvas::Canvas(int width, int height) : width(width), height(height) {
 }
 
 Canvas::~Canvas() {
-    // Unload all images in history
-    for (auto& img : undoStack) {
-        UnloadImage(img);
+    // Unload all snapshots in history
+    for (auto& snapshot : undoStack) {
+        UnloadSnapshot(snapshot);
     }
-    for (auto& img : redoStack) {
-        UnloadImage(img);
+    for (auto& snapshot : redoStack) {
+        UnloadSnapshot(snapshot);
+    }
+    UnloadSpareTextures();
+    if (uploadTexture.id != 0) {
+        UnloadTexture(uploadTexture);
     }
     UnloadRenderTexture(renderTexture);
 }
@@ -29,6 +45,11 @@ void Canvas::Clear(Color color) {
     BeginTextureMode(renderTexture);
     ClearBackground(color);
     EndTextureMode();
+
+    DrawCommand command;
+    command.type = DrawCommand::Type::CLEAR;
+    command.color = color;
+    RecordCommand(std::move(command));
 }
 
 void Canvas::BeginDrawing() {
@@ -39,36 +60,24 @@ void Canvas::EndDrawing() {
     EndTextureMode();
 }
 
-void Canvas::DrawPencilLine(Vector2 start, Vector2 end, Color color, float thickness) {
-    BeginTextureMode(renderTexture);
-
-    // Calculate distance between points
-    float dx = end.x - start.x;
-    float dy = end.y - start.y;
-    float distance = std::sqrt(dx * dx + dy * dy);
+void Canvas::DrawPencilStroke(const std::vector<Vector2>& path, Color color, float thickness) {
+    if (path.empty()) return;
 
-    // Circle radius (thickness is diameter)
     float radius = thickness / 2.0f;
 
-    // Step between circles - smaller values = denser circles
-    float step = std::max(1.0f, radius * 0.3f);
+    // One thick line per segment with round joints,
+    // instead of stamping circles along every segment.
+    // Thin strokes have no visible gaps at the joints.
+    bool roundJoints = radius > 1.0f;
 
-    if (distance < step) {
-        // If distance is small, draw single circle
-        DrawCircleV(end, radius, color);
-    } else {
-        // Interpolate circles between start and end
-        int steps = (int)(distance / step);
-        for (int i = 0; i <= steps; i++) {
-            float t = (float)i / (float)steps;
-            Vector2 pos = {
-                start.x + dx * t,
-                start.y + dy * t
-            };
-            DrawCircleV(pos, radius, color);
+    BeginTextureMode(renderTexture);
+    DrawCircleV(path[0], radius, color);
+    for (size_t i = 1; i < path.size(); i++) {
+        DrawLineEx(path[i - 1], path[i], thickness, color);
+        if (roundJoints || i == path.size() - 1) {
+            DrawCircleV(path[i], radius, color);
         }
     }
-
     EndTextureMode();
 }
 
@@ -85,6 +94,13 @@ void Canvas::DrawRectangleShape(Vector2 start, Vector2 end, Color color, bool fi
         DrawRectangleLines((int)x, (int)y, (int)w, (int)h, color);
     }
     EndTextureMode();
+
+    Vector2 corners[] = { start, end };
+    DrawCommand command;
+    command.type = DrawCommand::Type::RECTANGLE;
+    command.color = color;
+    command.filled = filled;
+    RecordCommand(std::move(command), corners, 2);
 }
 
 void Canvas::DrawCircleShape(Vector2 center, float radius, Color color, bool filled) {
@@ -95,15 +111,41 @@ void Canvas::DrawCircleShape(Vector2 center, float radius, Color color, bool fil
         DrawCircleLines((int)center.x, (int)center.y, radius, color);
     }
     EndTextureMode();
+
+    DrawCommand command;
+    command.type = DrawCommand::Type::CIRCLE;
+    command.color = color;
+    command.size = radius;
+    command.filled = filled;
+    RecordCommand(std::move(command), &center, 1);
+}
+
+void Canvas::DrawTextQuads(const GlyphAtlas& atlas, const std::vector<GlyphQuad>& quads) {
+    if (quads.empty()) return;
+
+    BeginTextureMode(renderTexture);
+    atlas.DrawQuads(quads, { 0, 0 });
+    EndTextureMode();
+
+    DrawCommand command;
+    command.type = DrawCommand::Type::TEXT;
+    command.image = atlas.GetImage();
+    command.quads = quads;
+    RecordCommand(std::move(command));
+}
+
+void Canvas::RecordStroke(const std::vector<Vector2>& points, Color color, float thickness) {
+    DrawCommand command;
+    command.type = DrawCommand::Type::STROKE;
+    command.color = color;
+    command.size = thickness;
+    RecordCommand(std::move(command), points.data(), points.size());
 }
 
 void Canvas::SaveState() {
     ClearRedoStack();
 
-    // Get current image from renderTexture
-    Image img = LoadImageFromTexture(renderTexture.texture);
-    ImageFlipVertical(&img); // RenderTexture is flipped
-    undoStack.push_back(img);
+    undoStack.push_back(CaptureSnapshot());
 
     TrimUndoStack();
 }
@@ -111,57 +153,23 @@ void Canvas::SaveState() {
 void Canvas::Undo() {
     if (!CanUndo()) return;
 
-    // Move current state to redo stack
-    Image currentImg = LoadImageFromTexture(renderTexture.texture);
-    ImageFlipVertical(&currentImg);
-    redoStack.push_back(currentImg);
-
-    // Remove last state from undo stack
+    // Current state is the top of the undo stack, move it to redo stack
+    redoStack.push_back(std::move(undoStack.back()));
     undoStack.pop_back();
 
     // Restore previous state
-    if (!undoStack.empty()) {
-        Image prevImg = ImageCopy(undoStack.back());
-        Texture2D tempTex = LoadTextureFromImage(prevImg);
-
-        BeginTextureMode(renderTexture);
-        ClearBackground(BLACK);
-        DrawTexture(tempTex, 0, 0, WHITE);
-        EndTextureMode();
-
-        UnloadTexture(tempTex);
-        UnloadImage(prevImg);
-    } else {
-        // If stack is empty, clear canvas
-        BeginTextureMode(renderTexture);
-        ClearBackground(BLACK);
-        EndTextureMode();
-
-        // Add empty state
-        SaveState();
-    }
+    RestoreSnapshot(undoStack.back());
 }
 
 void Canvas::Redo() {
     if (!CanRedo()) return;
 
-    // Get state from redo stack
-    Image redoImg = redoStack.back();
+    // Move state from redo stack back to undo stack
+    undoStack.push_back(std::move(redoStack.back()));
     redoStack.pop_back();
 
-    // Save current state to undo stack
-    undoStack.push_back(ImageCopy(redoImg));
-
     // Restore state
-    Texture2D tempTex = LoadTextureFromImage(redoImg);
-
-    BeginTextureMode(renderTexture);
-    ClearBackground(BLACK);
-    DrawTexture(tempTex, 0, 0, WHITE);
-    EndTextureMode();
-
-    UnloadTexture(tempTex);
-    UnloadImage(redoImg);
+    RestoreSnapshot(undoStack.back());
 }
 
 bool Canvas::CanUndo() const {
@@ -172,10 +180,73 @@ bool Canvas::CanRedo() const {
     return !redoStack.empty();
 }
 
+void Canvas::UpdateHistory() {
+    // Spare textures stay in VRAM too, so they count against the budget
+    size_t spareBytes = spareTextures.size() * TextureBytes(renderTexture);
+    if (gpuHistoryBytes + spareBytes <= GPU_HISTORY_BUDGET) return;
+
+    // Spill the snapshot farthest from the current state.
+    // Only one per frame, so the readback cost is spread out.
+    Snapshot* farthest = nullptr;
+    size_t farthestDistance = 0;
+
+    // Top of the undo stack is the current state, keep it on the GPU
+    for (size_t i = 0; i + 1 < undoStack.size(); i++) {
+        size_t distance = undoStack.size() - 1 - i;
+        if (undoStack[i].onGpu && distance > farthestDistance) {
+            farthest = &undoStack[i];
+            farthestDistance = distance;
+        }
+    }
+    for (size_t i = 0; i < redoStack.size(); i++) {
+        size_t distance = redoStack.size() - i;
+        if (redoStack[i].onGpu && distance > farthestDistance) {
+            farthest = &redoStack[i];
+            farthestDistance = distance;
+        }
+    }
+
+    if (farthest != nullptr) {
+        SpillSnapshot(*farthest);
+    } else {
+        // Nothing left to spill, only the spares are over budget
+        UnloadSpareTextures();
+    }
+}
+
+void Canvas::SetStoragePalette(const Color* colors, int count) {
+    storagePalette.assign(1, BLACK);
+    for (int i = 0; i < count && (int)storagePalette.size() < MAX_INDEXED_COLORS; i++) {
+        storagePalette.push_back(colors[i]);
+    }
+}
+
 void Canvas::SaveToPNG(const char* filename) {
+    // Rows come back bottom-up (RenderTexture is flipped)
     Image img = LoadImageFromTexture(renderTexture.texture);
-    ImageFlipVertical(&img);
-    ExportImage(img, filename);
+
+    // Only palette colors unless a PNG with other colors was loaded
+    IndexedImage indexed;
+    indexed.indices = pixelPool.Acquire((size_t)img.width * img.height);
+    if (IndexImage(img, storagePalette.data(), (int)storagePalette.size(), indexed)) {
+        // Writing the rows in reverse order replaces the flip
+        PngWriter writer;
+        bool saved = writer.OpenIndexed(filename, indexed.width, indexed.height,
+                                        storagePalette.data(), (int)storagePalette.size(), 4);
+        if (saved) {
+            for (int y = indexed.height - 1; y >= 0; y--) {
+                writer.WriteRow(&indexed.indices[(size_t)y * indexed.width]);
+            }
+            saved = writer.Close();
+        }
+        if (!saved) {
+            TraceLog(LOG_WARNING, "Failed to save %s", filename);
+        }
+    } else {
+        ImageFlipVertical(&img);
+        ExportImage(img, filename);
+    }
+    pixelPool.Release(indexed.indices);
     UnloadImage(img);
 }
 
@@ -190,62 +261,259 @@ void Canvas::LoadFromPNG(const char* filename) {
         ImageResize(&img, width, height);
     }
 
-    ImageFlipVertical(&img);
-    Texture2D tempTex = LoadTextureFromImage(img);
+    // File rows are top-down, drawn upright through the shared upload texture.
+    // The RGBA image is also kept for the scaled export.
+    ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    UploadPixels(img.data, img.width, img.height, false);
 
-    BeginTextureMode(renderTexture);
-    ClearBackground(BLACK);
-    DrawTexture(tempTex, 0, 0, WHITE);
-    EndTextureMode();
+    DrawCommand clear;
+    clear.type = DrawCommand::Type::CLEAR;
+    clear.color = BLACK;
+    RecordCommand(std::move(clear));
 
-    UnloadTexture(tempTex);
-    UnloadImage(img);
+    DrawCommand command;
+    command.type = DrawCommand::Type::IMAGE;
+    command.image = std::shared_ptr<const Image>(new Image(img), [](const Image* image) {
+        UnloadImage(*image);
+        delete image;
+    });
+    RecordCommand(std::move(command));
 
     SaveState();
 }
 
+bool Canvas::ExportScaledPNG(const char* filename, int scale) {
+    // Nothing before the last clear is visible
+    size_t first = activeCommands;
+    while (first > 0 && commands[first - 1].type != DrawCommand::Type::CLEAR) {
+        first--;
+    }
+    if (first > 0) first--;
+
+    TiledExporter exporter(commands.data() + first, activeCommands - first, commandPoints.data(),
+                           width, height, storagePalette);
+    bool saved = exporter.Export(filename, scale);
+    if (!saved) {
+        TraceLog(LOG_WARNING, "Failed to export %s", filename);
+    }
+    return saved;
+}
+
 void Canvas::Resize(int newWidth, int newHeight) {
     if (newWidth == width && newHeight == height) return;
     if (newWidth <= 0 || newHeight <= 0) return;
 
-    // Save current content
-    Image currentImg = LoadImageFromTexture(renderTexture.texture);
-    ImageFlipVertical(&currentImg);
+    // Copy old content to the new renderTexture on the GPU
+    RenderTexture2D newTexture = LoadRenderTexture(newWidth, newHeight);
+
+    BeginTextureMode(newTexture);
+    ClearBackground(BLACK);
+    DrawTextureRec(renderTexture.texture, { 0, 0, (float)width, -(float)height }, { 0, 0 }, WHITE);
+    EndTextureMode();
 
-    // Create new renderTexture
     UnloadRenderTexture(renderTexture);
-    renderTexture = LoadRenderTexture(newWidth, newHeight);
+    renderTexture = newTexture;
 
-    // Redraw old content to new renderTexture
-    ImageFlipVertical(&currentImg);
-    Texture2D tempTex = LoadTextureFromImage(currentImg);
+    // Shrinking loses content, record it for the scaled export.
+    // Redo states were drawn before the crop, so they are dropped with
+    // their commands.
+    if (newWidth < width || newHeight < height) {
+        ClearRedoStack();
 
-    BeginTextureMode(renderTexture);
-    ClearBackground(BLACK);
-    DrawTexture(tempTex, 0, 0, WHITE);
-    EndTextureMode();
+        Vector2 size = { (float)newWidth, (float)newHeight };
+        DrawCommand command;
+        command.type = DrawCommand::Type::CROP;
+        RecordCommand(std::move(command), &size, 1);
 
-    UnloadTexture(tempTex);
-    UnloadImage(currentImg);
+        // The current state now includes the crop, so Undo then Redo keeps it
+        undoStack.back().commandCount = activeCommands;
+    }
 
     width = newWidth;
     height = newHeight;
+
+    // Spare textures have the old size
+    UnloadSpareTextures();
 }
 
 Texture2D Canvas::GetTexture() const {
     return renderTexture.texture;
 }
 
-void Canvas::ClearRedoStack() {
-    for (auto& img : redoStack) {
+Canvas::Snapshot Canvas::CaptureSnapshot() {
+    Snapshot snapshot = {};
+    snapshot.onGpu = true;
+
+    if (!spareTextures.empty()) {
+        snapshot.gpu = spareTextures.back();
+        spareTextures.pop_back();
+    } else {
+        snapshot.gpu = LoadRenderTexture(width, height);
+    }
+
+    // GPU-side copy, both textures keep the same (flipped) orientation
+    BeginTextureMode(snapshot.gpu);
+    ClearBackground(BLACK);
+    DrawTextureRec(renderTexture.texture, { 0, 0, (float)width, -(float)height }, { 0, 0 }, WHITE);
+    EndTextureMode();
+
+    gpuHistoryBytes += TextureBytes(snapshot.gpu);
+    snapshot.commandCount = activeCommands;
+    return snapshot;
+}
+
+void Canvas::RestoreSnapshot(const Snapshot& snapshot) {
+    activeCommands = snapshot.commandCount;
+
+    if (snapshot.onGpu) {
+        Texture2D tex = snapshot.gpu.texture;
+
+        BeginTextureMode(renderTexture);
+        ClearBackground(BLACK);
+        DrawTextureRec(tex, { 0, 0, (float)tex.width, -(float)tex.height }, { 0, 0 }, WHITE);
+        EndTextureMode();
+    } else if (snapshot.cpu.data != nullptr) {
+        UploadPixels(snapshot.cpu.data, snapshot.cpu.width, snapshot.cpu.height, true);
+    } else {
+        // Expand palette indices into a pooled RGBA buffer
+        const IndexedImage& indexed = snapshot.indexed;
+        std::vector<unsigned char> pixels = pixelPool.Acquire((size_t)indexed.width * indexed.height * 4);
+        ExpandIndexedImage(indexed, storagePalette.data(), (int)storagePalette.size(), pixels.data());
+
+        UploadPixels(pixels.data(), indexed.width, indexed.height, true);
+        pixelPool.Release(pixels);
+    }
+}
+
+void Canvas::UploadPixels(const void* pixels, int w, int h, bool bottomUp) {
+    // Reuse one RGBA texture for all uploads of this size
+    if (uploadTexture.id == 0 || uploadTexture.width != w || uploadTexture.height != h) {
+        if (uploadTexture.id != 0) {
+            UnloadTexture(uploadTexture);
+        }
+        Image blank = GenImageColor(w, h, BLACK);
+        uploadTexture = LoadTextureFromImage(blank);
+        UnloadImage(blank);
+    }
+    UpdateTexture(uploadTexture, pixels);
+
+    // Bottom-up rows are drawn flipped, same as the RenderTexture itself
+    Rectangle source = { 0, 0, (float)w, bottomUp ? -(float)h : (float)h };
+
+    BeginTextureMode(renderTexture);
+    ClearBackground(BLACK);
+    DrawTextureRec(uploadTexture, source, { 0, 0 }, WHITE);
+    EndTextureMode();
+}
+
+void Canvas::SpillSnapshot(Snapshot& snapshot) {
+    if (!snapshot.onGpu) return;
+
+    // Rows stay bottom-up (RenderTexture is flipped), no flip needed
+    // since restoring draws them flipped again
+    Image img = LoadImageFromTexture(snapshot.gpu.texture);
+
+    gpuHistoryBytes -= TextureBytes(snapshot.gpu);
+    ReleaseTexture(snapshot.gpu);
+
+    snapshot.gpu = {};
+    snapshot.onGpu = false;
+
+    // 1 byte per pixel instead of 4
+    snapshot.indexed.indices = pixelPool.Acquire((size_t)img.width * img.height);
+    if (IndexImage(img, storagePalette.data(), (int)storagePalette.size(), snapshot.indexed)) {
         UnloadImage(img);
+    } else {
+        pixelPool.Release(snapshot.indexed.indices);
+        snapshot.cpu = img;
+    }
+}
+
+void Canvas::UnloadSnapshot(Snapshot& snapshot) {
+    if (snapshot.onGpu) {
+        gpuHistoryBytes -= TextureBytes(snapshot.gpu);
+        ReleaseTexture(snapshot.gpu);
+    } else if (snapshot.cpu.data != nullptr) {
+        UnloadImage(snapshot.cpu);
+    }
+    pixelPool.Release(snapshot.indexed.indices);
+    snapshot.gpu = {};
+    snapshot.cpu = {};
+    snapshot.onGpu = false;
+}
+
+void Canvas::ReleaseTexture(RenderTexture2D target) {
+    // Keep a few textures of the current size for the next snapshots
+    if (target.texture.width == width && target.texture.height == height &&
+        spareTextures.size() < MAX_SPARE_TEXTURES) {
+        spareTextures.push_back(target);
+    } else {
+        UnloadRenderTexture(target);
+    }
+}
+
+void Canvas::UnloadSpareTextures() {
+    for (auto& target : spareTextures) {
+        UnloadRenderTexture(target);
+    }
+    spareTextures.clear();
+}
+
+size_t Canvas::TextureBytes(const RenderTexture2D& target) {
+    return (size_t)target.texture.width * (size_t)target.texture.height * 4;
+}
+
+void Canvas::RecordCommand(DrawCommand command, const Vector2* points, size_t pointCount) {
+    // Drawing after an undo drops the commands of the redo states
+    if (commands.size() > activeCommands) {
+        commandPoints.resize(commands[activeCommands].firstPoint);
+        commands.erase(commands.begin() + activeCommands, commands.end());
+    }
+    command.firstPoint = commandPoints.size();
+    command.pointCount = pointCount;
+    commandPoints.insert(commandPoints.end(), points, points + pointCount);
+
+    commands.push_back(std::move(command));
+    activeCommands = commands.size();
+}
+
+void Canvas::PruneCommands() {
+    // The export starts at the last clear, so commands before the last clear
+    // of the oldest state in history are never needed again
+    size_t clear = undoStack.front().commandCount;
+    while (clear > 0 && commands[clear - 1].type != DrawCommand::Type::CLEAR) {
+        clear--;
+    }
+    if (clear <= 1) return;
+
+    size_t dropped = clear - 1;
+    size_t droppedPoints = commands[dropped].firstPoint;
+    commands.erase(commands.begin(), commands.begin() + dropped);
+    commandPoints.erase(commandPoints.begin(), commandPoints.begin() + droppedPoints);
+
+    for (auto& command : commands) {
+        command.firstPoint -= droppedPoints;
+    }
+    for (auto& snapshot : undoStack) {
+        snapshot.commandCount -= dropped;
+    }
+    for (auto& snapshot : redoStack) {
+        snapshot.commandCount -= dropped;
+    }
+    activeCommands -= dropped;
+}
+
+void Canvas::ClearRedoStack() {
+    for (auto& snapshot : redoStack) {
+        UnloadSnapshot(snapshot);
     }
     redoStack.clear();
 }
 
 void Canvas::TrimUndoStack() {
     while (undoStack.size() > MAX_HISTORY) {
-        UnloadImage(undoStack.front());
+        UnloadSnapshot(undoStack.front());
         undoStack.erase(undoStack.begin());
     }
+    PruneCommands();
 }
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <raylib.h>
+#include <cstddef>
 #include <vector>
+#include "DrawCommand.h"
+#include "IndexedImage.h"
+#include "PixelBufferPool.h"
 
 class Canvas {
 public:
@@ -13,9 +17,14 @@ public:
     void EndDrawing();
 
     // Drawing tools
-    void DrawPencilLine(Vector2 start, Vector2 end, Color color, float thickness);
+    void DrawPencilStroke(const std::vector<Vector2>& path, Color color, float thickness);
     void DrawRectangleShape(Vector2 start, Vector2 end, Color color, bool filled);
     void DrawCircleShape(Vector2 center, float radius, Color color, bool filled);
+    void DrawTextQuads(const GlyphAtlas& atlas, const std::vector<GlyphQuad>& quads);
+
+    // Pencil strokes are drawn piecewise while the mouse moves,
+    // the finished stroke's simplified points are recorded once
+    void RecordStroke(const std::vector<Vector2>& points, Color color, float thickness);
 
     // History
     void SaveState();
@@ -23,10 +32,17 @@ public:
     void Redo();
     bool CanUndo() const;
     bool CanRedo() const;
+    void UpdateHistory(); // call once per frame, moves old history to RAM
+
+    // Colors stored as palette indices in history and exports,
+    // background (black) is added as index 0
+    void SetStoragePalette(const Color* colors, int count);
 
     // Files
     void SaveToPNG(const char* filename);
     void LoadFromPNG(const char* filename);
+    // Draw the board again at scale times the canvas size
+    bool ExportScaledPNG(const char* filename, int scale);
 
     // Resize
     void Resize(int newWidth, int newHeight);
@@ -41,11 +57,58 @@ private:
     int width;
     int height;
 
+    // History entry, kept as a GPU texture while recent, spilled to RAM when old.
+    // In RAM it is stored as palette indices, or as RGBA if it has other colors,
+    // with rows in RenderTexture order (bottom-up) so no flip is needed.
+    struct Snapshot {
+        RenderTexture2D gpu;
+        Image cpu;
+        IndexedImage indexed;
+        bool onGpu;
+        size_t commandCount; // recorded commands in this state
+    };
+
     // History for undo/redo
-    std::vector<Image> undoStack;
-    std::vector<Image> redoStack;
+    std::vector<Snapshot> undoStack;
+    std::vector<Snapshot> redoStack;
     static constexpr int MAX_HISTORY = 50;
 
+    // VRAM used by history textures, spare textures are added on top
+    // when checking the budget
+    size_t gpuHistoryBytes;
+    static constexpr size_t GPU_HISTORY_BUDGET = 128 * 1024 * 1024;
+
+    std::vector<Color> storagePalette;
+
+    // Everything drawn since the last clear still in history, for the scaled
+    // export. Commands past activeCommands belong to redo states.
+    std::vector<DrawCommand> commands;
+    std::vector<Vector2> commandPoints; // points of all commands, in order
+    size_t activeCommands;
+    static constexpr size_t COMMAND_RESERVE = 4096;
+    static constexpr size_t POINT_RESERVE = 64 * 1024;
+
+    // Reused buffers for indexed history and export,
+    // and one texture for uploading CPU pixels
+    PixelBufferPool pixelPool;
+    Texture2D uploadTexture;
+
+    // Textures of dropped snapshots, reused by the next SaveState
+    std::vector<RenderTexture2D> spareTextures;
+    static constexpr size_t MAX_SPARE_TEXTURES = 4;
+
+    Snapshot CaptureSnapshot();
+    void RestoreSnapshot(const Snapshot& snapshot);
+    void SpillSnapshot(Snapshot& snapshot);
+    void UnloadSnapshot(Snapshot& snapshot);
+    void ReleaseTexture(RenderTexture2D target);
+    void UploadPixels(const void* pixels, int w, int h, bool bottomUp);
+    void UnloadSpareTextures();
+    static size_t TextureBytes(const RenderTexture2D& target);
+
+    void RecordCommand(DrawCommand command, const Vector2* points = nullptr, size_t pointCount = 0);
+    void PruneCommands();
+
     void ClearRedoStack();
     void TrimUndoStack();
 };
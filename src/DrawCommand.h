@@ -0,0 +1,32 @@
+#pragma once
+
+#include <raylib.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "GlyphAtlas.h"
+
+// One drawing operation on the canvas, kept so the board
+// can be drawn again at a higher resolution for export.
+// Points of all commands live in one array owned by the Canvas,
+// so recording a command does not allocate.
+struct DrawCommand {
+    enum class Type {
+        STROKE,     // points: simplified stroke points, size: thickness
+        RECTANGLE,  // points: two corners
+        CIRCLE,     // points: center, size: radius
+        CLEAR,      // whole canvas filled with color
+        CROP,       // canvas resized, points: new size, content outside is lost
+        IMAGE,      // loaded PNG drawn at 0,0
+        TEXT        // quads: glyphs and note backgrounds, image: glyph atlas
+    };
+
+    Type type = Type::CLEAR;
+    Color color = BLACK;
+    size_t firstPoint = 0; // index into the shared point array
+    size_t pointCount = 0;
+    float size = 0.0f;
+    bool filled = false;
+    std::shared_ptr<const Image> image; // RGBA, only for IMAGE and TEXT
+    std::vector<GlyphQuad> quads;       // only for TEXT
+};
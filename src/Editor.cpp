@@ -7,13 +7,13 @@
 #include <ctime>
 #include <cstdio>
 
-static std::string GetTimestampFilename() {
+static std::string GetTimestampFilename(const char* suffix = "") {
     std::time_t now = std::time(nullptr);
     std::tm* t = std::localtime(&now);
     char buffer[64];
-    std::snprintf(buffer, sizeof(buffer), "whiteboard_%02d%02d%02d_%02d%02d%02d.png",
+    std::snprintf(buffer, sizeof(buffer), "whiteboard_%02d%02d%02d_%02d%02d%02d%s.png",
                   t->tm_year % 100, t->tm_mon + 1, t->tm_mday,
-                  t->tm_hour, t->tm_min, t->tm_sec);
+                  t->tm_hour, t->tm_min, t->tm_sec, suffix);
     return buffer;
 }
 
@@ -22,11 +22,14 @@ Editor::Editor(int windowWidth, int windowHeight)
     , windowHeight(windowHeight)
     , currentTool(Tool::PENCIL)
     , brushSize(2.0f)
+    , exportScale(4.0f)
     , fillShapes(false)
     , isDrawing(false)
     , startPos({0, 0})
     , lastPos({0, 0})
     , currentPos({0, 0})
+    , strokeSegmentsDrawn(0)
+    , strokeColor(WHITE)
     , showSaveDialog(false)
     , showLoadDialog(false)
 {
@@ -38,12 +41,20 @@ Editor::Editor(int windowWidth, int windowHeight)
     int canvasWidth = windowWidth - MENU_WIDTH;
     int canvasHeight = windowHeight;
     canvas = std::make_unique<Canvas>(canvasWidth, canvasHeight);
+    canvas->SetStoragePalette(palette.GetColors().data(), Palette::COLOR_COUNT);
+
+    glyphAtlas = std::make_unique<GlyphAtlas>();
+    textLayer = std::make_unique<TextLayer>(*glyphAtlas);
 
     // Set GUI style
     GuiSetStyle(DEFAULT, TEXT_SIZE, 14);
 }
 
 Editor::~Editor() {
+    // Textures (history, atlas) must go before the GL context
+    textLayer.reset();
+    glyphAtlas.reset();
+    canvas.reset();
     CloseWindow();
 }
 
@@ -69,6 +80,8 @@ void Editor::Update() {
         canvas->Resize(canvasWidth, canvasHeight);
     }
 
+    canvas->UpdateHistory();
+
     // Hide cursor only when actively drawing
     if (isDrawing && IsMouseOnCanvas()) {
         HideCursor();
@@ -77,6 +90,13 @@ void Editor::Update() {
     }
 
     HandleInput();
+
+    // Notes stay editable only with the text tool
+    if (currentTool != Tool::TEXT) {
+        textLayer->Deselect();
+    }
+    // Escape leaves the note being edited instead of closing the window
+    SetExitKey(textLayer->IsEditing() ? KEY_NULL : KEY_ESCAPE);
 }
 
 void Editor::Draw() {
@@ -90,6 +110,24 @@ void Editor::Draw() {
     Rectangle dest = { (float)MENU_WIDTH, 0, (float)canvasTex.width, (float)canvasTex.height };
     DrawTexturePro(canvasTex, source, dest, {0, 0}, 0, WHITE);
 
+    // Preview the part of the stroke that is not on the canvas yet
+    if (stroke.IsActive()) {
+        const auto& points = stroke.GetPoints();
+        float radius = brushSize / 2.0f;
+        Vector2 offset = { (float)MENU_WIDTH, 0 };
+
+        Vector2 prev = points[std::min(strokeSegmentsDrawn, points.size() - 1)];
+        prev = { prev.x + offset.x, prev.y + offset.y };
+        DrawCircleV(prev, radius, strokeColor);
+        for (size_t i = strokeSegmentsDrawn + 1; i <= points.size(); i++) {
+            Vector2 p = i < points.size() ? points[i] : stroke.GetTail();
+            p = { p.x + offset.x, p.y + offset.y };
+            DrawLineEx(prev, p, brushSize, strokeColor);
+            DrawCircleV(p, radius, strokeColor);
+            prev = p;
+        }
+    }
+
     // Preview when drawing shapes
     if (isDrawing && (currentTool == Tool::RECTANGLE || currentTool == Tool::CIRCLE)) {
         Color previewColor = palette.GetCurrentColor();
@@ -120,6 +158,11 @@ void Editor::Draw() {
         }
     }
 
+    // Text notes not committed yet, all in one batch
+    Vector2 textOffset = { (float)MENU_WIDTH, 0 };
+    textLayer->Draw(textOffset);
+    textLayer->DrawEditingMarks(textOffset);
+
     // GUI on left side
     DrawGUI();
 
@@ -131,6 +174,7 @@ void Editor::DrawGUI() {
     DrawRectangle(0, 0, MENU_WIDTH, windowHeight, LIGHTGRAY);
 
     int yPos = BUTTON_PADDING;
+    float halfWidth = (MENU_WIDTH - 3*BUTTON_PADDING) / 2.0f; // two buttons in a row
 
     // === TOOLS ===
     GuiLabel({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), 20}, "TOOLS");
@@ -164,7 +208,14 @@ void Editor::DrawGUI() {
     }
     yPos += BUTTON_HEIGHT + BUTTON_PADDING;
 
-    // Fill checkbox (only for shapes)
+    // Text
+    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT},
+                  currentTool == Tool::TEXT ? "> Text" : "Text")) {
+        currentTool = Tool::TEXT;
+    }
+    yPos += BUTTON_HEIGHT + BUTTON_PADDING;
+
+    // Fill checkbox (shapes, and sticky notes for text)
     GuiCheckBox({(float)BUTTON_PADDING, (float)yPos, 20, 20}, "Fill shapes", &fillShapes);
     yPos += 30;
 
@@ -211,24 +262,29 @@ void Editor::DrawGUI() {
     GuiLabel({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), 20}, "ACTIONS");
     yPos += 25;
 
-    // Undo
+    // Undo and Redo share a row (Ctrl+Z / Ctrl+Y)
     GuiSetState(canvas->CanUndo() ? STATE_NORMAL : STATE_DISABLED);
-    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT}, "Undo (Ctrl+Z)")) {
+    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, halfWidth, (float)BUTTON_HEIGHT}, "Undo")) {
         canvas->Undo();
     }
+    GuiSetState(canvas->CanRedo() ? STATE_NORMAL : STATE_DISABLED);
+    if (GuiButton({2*BUTTON_PADDING + halfWidth, (float)yPos, halfWidth, (float)BUTTON_HEIGHT}, "Redo")) {
+        canvas->Redo();
+    }
     GuiSetState(STATE_NORMAL);
     yPos += BUTTON_HEIGHT + BUTTON_PADDING;
 
-    // Redo
-    GuiSetState(canvas->CanRedo() ? STATE_NORMAL : STATE_DISABLED);
-    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT}, "Redo (Ctrl+Y)")) {
-        canvas->Redo();
+    // Commit Text
+    GuiSetState(textLayer->IsEmpty() ? STATE_DISABLED : STATE_NORMAL);
+    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT}, "Commit Text")) {
+        CommitText();
     }
     GuiSetState(STATE_NORMAL);
     yPos += BUTTON_HEIGHT + BUTTON_PADDING;
 
     // Clear All
     if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT}, "Clear All")) {
+        textLayer->Clear();
         canvas->Clear(BLACK);
         canvas->SaveState();
     }
@@ -242,21 +298,32 @@ void Editor::DrawGUI() {
     GuiLabel({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), 20}, "FILES");
     yPos += 25;
 
-    // Save PNG
-    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT}, "Save PNG")) {
+    // Save and Open PNG share a row
+    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, halfWidth, (float)BUTTON_HEIGHT}, "Save")) {
+        CommitText();
         std::string filename = GetTimestampFilename();
         canvas->SaveToPNG(filename.c_str());
         TraceLog(LOG_INFO, "Saved to %s", filename.c_str());
     }
-    yPos += BUTTON_HEIGHT + BUTTON_PADDING;
-
-    // Open PNG
-    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT}, "Open PNG")) {
+    if (GuiButton({2*BUTTON_PADDING + halfWidth, (float)yPos, halfWidth, (float)BUTTON_HEIGHT}, "Open")) {
+        CommitText();
         canvas->LoadFromPNG("whiteboard.png");
         TraceLog(LOG_INFO, "Loaded from whiteboard.png");
     }
     yPos += BUTTON_HEIGHT + BUTTON_PADDING;
 
+    // Export scale, shown on the button below
+    GuiSliderBar({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING - 30), 20},
+                 "1", "16", &exportScale, 1.0f, 16.0f);
+    yPos += 25;
+
+    // Export at scale
+    std::string exportLabel = "Export x" + std::to_string((int)exportScale);
+    if (GuiButton({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), (float)BUTTON_HEIGHT}, exportLabel.c_str())) {
+        ExportScaled();
+    }
+    yPos += BUTTON_HEIGHT + BUTTON_PADDING;
+
     // === BRUSH SIZE ===
     yPos += 10;
     GuiLabel({(float)BUTTON_PADDING, (float)yPos, (float)(MENU_WIDTH - 2*BUTTON_PADDING), 20}, "BRUSH SIZE");
@@ -279,40 +346,63 @@ void Editor::HandleInput() {
             canvas->Redo();
         }
         if (IsKeyPressed(KEY_S)) {
+            CommitText();
             std::string filename = GetTimestampFilename();
             canvas->SaveToPNG(filename.c_str());
         }
         if (IsKeyPressed(KEY_O)) {
+            CommitText();
             canvas->LoadFromPNG("whiteboard.png");
         }
+        if (IsKeyPressed(KEY_E)) {
+            ExportScaled();
+        }
+        if (IsKeyPressed(KEY_ENTER)) {
+            CommitText();
+        }
     }
 
-    // Switch tools with keys
-    if (IsKeyPressed(KEY_ONE)) currentTool = Tool::PENCIL;
-    if (IsKeyPressed(KEY_TWO)) currentTool = Tool::ERASER;
-    if (IsKeyPressed(KEY_THREE)) currentTool = Tool::RECTANGLE;
-    if (IsKeyPressed(KEY_FOUR)) currentTool = Tool::CIRCLE;
+    if (textLayer->IsEditing()) {
+        // Keys go to the note, not to the tool shortcuts
+        textLayer->HandleTyping();
+    } else {
+        // Switch tools with keys
+        if (IsKeyPressed(KEY_ONE)) currentTool = Tool::PENCIL;
+        if (IsKeyPressed(KEY_TWO)) currentTool = Tool::ERASER;
+        if (IsKeyPressed(KEY_THREE)) currentTool = Tool::RECTANGLE;
+        if (IsKeyPressed(KEY_FOUR)) currentTool = Tool::CIRCLE;
+        if (IsKeyPressed(KEY_FIVE)) currentTool = Tool::TEXT;
+    }
 
     // Drawing
     if (IsMouseOnCanvas()) {
         Vector2 canvasPos = GetCanvasMousePos();
 
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && currentTool == Tool::TEXT) {
+            // Edit the note under the cursor, or start a new one
+            if (!textLayer->SelectNoteAt(canvasPos)) {
+                textLayer->AddNote(canvasPos, palette.GetCurrentColor(), GetTextBucket(), fillShapes);
+            }
+        } else if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
             isDrawing = true;
             startPos = canvasPos;
             lastPos = canvasPos;
+
+            if (currentTool == Tool::PENCIL || currentTool == Tool::ERASER) {
+                stroke.Begin(canvasPos, brushSize);
+                strokeSegmentsDrawn = 0;
+                strokeColor = GetStrokeColor();
+            }
         }
 
         if (isDrawing) {
             currentPos = canvasPos;
 
-            if (currentTool == Tool::PENCIL) {
-                // Pencil draws continuously
-                canvas->DrawPencilLine(lastPos, currentPos, palette.GetCurrentColor(), brushSize);
-                lastPos = currentPos;
-            } else if (currentTool == Tool::ERASER) {
-                // Eraser draws black (background color)
-                canvas->DrawPencilLine(lastPos, currentPos, BLACK, brushSize);
+            if (stroke.IsActive()) {
+                // Samples are simplified as they arrive, finished curve
+                // segments go to the canvas
+                stroke.AddPoint(currentPos);
+                FlushStroke();
                 lastPos = currentPos;
             }
             // Rectangle and Circle draw on button release
@@ -320,6 +410,7 @@ void Editor::HandleInput() {
 
         if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && isDrawing) {
             isDrawing = false;
+            FinishStroke();
 
             if (currentTool == Tool::PENCIL || currentTool == Tool::ERASER) {
                 canvas->SaveState();
@@ -339,6 +430,7 @@ void Editor::HandleInput() {
         // If mouse leaves canvas during drawing
         if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && isDrawing) {
             isDrawing = false;
+            FinishStroke();
             if (currentTool == Tool::PENCIL || currentTool == Tool::ERASER) {
                 canvas->SaveState();
             }
@@ -346,6 +438,56 @@ void Editor::HandleInput() {
     }
 }
 
+void Editor::FlushStroke() {
+    size_t stable = stroke.GetStableSegmentCount();
+    if (stable <= strokeSegmentsDrawn) return;
+
+    // strokePath keeps its capacity between strokes
+    strokePath.clear();
+    strokePath.push_back(stroke.GetPoints()[strokeSegmentsDrawn]);
+    for (size_t i = strokeSegmentsDrawn; i < stable; i++) {
+        stroke.AppendSmoothedSegment(i, strokePath);
+    }
+
+    canvas->DrawPencilStroke(strokePath, strokeColor, brushSize);
+    strokeSegmentsDrawn = stable;
+}
+
+void Editor::FinishStroke() {
+    if (!stroke.IsActive()) return;
+
+    stroke.End();
+
+    if (stroke.GetPoints().size() == 1) {
+        // Single click draws a dot
+        canvas->DrawPencilStroke(stroke.GetPoints(), strokeColor, brushSize);
+    } else {
+        FlushStroke();
+    }
+    canvas->RecordStroke(stroke.GetPoints(), strokeColor, brushSize);
+}
+
+void Editor::ExportScaled() {
+    CommitText();
+
+    int scale = (int)exportScale;
+    std::string suffix = "_x" + std::to_string(scale);
+    std::string filename = GetTimestampFilename(suffix.c_str());
+    if (canvas->ExportScaledPNG(filename.c_str(), scale)) {
+        TraceLog(LOG_INFO, "Exported %dx to %s", scale, filename.c_str());
+    }
+}
+
+void Editor::CommitText() {
+    textLayer->Deselect();
+    if (textLayer->IsEmpty()) return;
+
+    // Drawn in one pass and recorded as one command, one undo step
+    canvas->DrawTextQuads(*glyphAtlas, textLayer->GetQuads());
+    textLayer->Clear();
+    canvas->SaveState();
+}
+
 bool Editor::IsMouseOnCanvas() const {
     Vector2 mousePos = GetMousePosition();
     return mousePos.x >= MENU_WIDTH && mousePos.x < windowWidth &&
@@ -356,3 +498,13 @@ Vector2 Editor::GetCanvasMousePos() const {
     Vector2 mousePos = GetMousePosition();
     return { mousePos.x - MENU_WIDTH, mousePos.y };
 }
+
+Color Editor::GetStrokeColor() const {
+    // Eraser draws black (background color)
+    return currentTool == Tool::ERASER ? BLACK : palette.GetCurrentColor();
+}
+
+int Editor::GetTextBucket() const {
+    // Brush size picks the text size: 10, 20, 30 or 40 px
+    return std::min((int)brushSize / 12, GlyphAtlas::BUCKET_COUNT - 1);
+}
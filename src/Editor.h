@@ -3,14 +3,19 @@
 #include <raylib.h>
 #include <memory>
 #include <string>
+#include <vector>
 #include "Canvas.h"
 #include "Palette.h"
+#include "Stroke.h"
+#include "GlyphAtlas.h"
+#include "TextLayer.h"
 
 enum class Tool {
     PENCIL,
     ERASER,
     RECTANGLE,
-    CIRCLE
+    CIRCLE,
+    TEXT
 };
 
 class Editor {
@@ -28,10 +33,13 @@ private:
     // Components
     std::unique_ptr<Canvas> canvas;
     Palette palette;
+    std::unique_ptr<GlyphAtlas> glyphAtlas; // needs the window, created after InitWindow
+    std::unique_ptr<TextLayer> textLayer;
 
     // Tools
     Tool currentTool;
     float brushSize;
+    float exportScale;
     bool fillShapes;
 
     // Drawing state
@@ -40,6 +48,12 @@ private:
     Vector2 lastPos;
     Vector2 currentPos;
 
+    // Pencil/eraser stroke in progress
+    Stroke stroke;
+    size_t strokeSegmentsDrawn;
+    Color strokeColor;
+    std::vector<Vector2> strokePath;
+
     // GUI dimensions
     static constexpr int MENU_WIDTH = 120;
     static constexpr int BUTTON_HEIGHT = 30;
@@ -51,10 +65,16 @@ private:
     void Draw();
     void DrawGUI();
     void HandleInput();
+    void FlushStroke();
+    void FinishStroke();
+    void ExportScaled();
+    void CommitText();
 
     // Helpers
     bool IsMouseOnCanvas() const;
     Vector2 GetCanvasMousePos() const;
+    Color GetStrokeColor() const;
+    int GetTextBucket() const;
 
     // File dialog helpers
     std::string saveFilename;
@@ -0,0 +1,188 @@
+#include "GlyphAtlas.h"
+#include <rlgl.h>
+#include <algorithm>
+
+// Decode one UTF-8 codepoint at text[i], advances i. Invalid bytes give '?'.
+static int NextCodepoint(const std::string& text, size_t& i) {
+    unsigned char c = (unsigned char)text[i++];
+    if (c < 0x80) return c;
+
+    int extra = (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : -1;
+    if (extra < 0) return '?';
+
+    int codepoint = c & (0x3F >> extra);
+    for (int k = 0; k < extra; k++) {
+        if (i >= text.size() || ((unsigned char)text[i] & 0xC0) != 0x80) return '?';
+        codepoint = (codepoint << 6) | ((unsigned char)text[i++] & 0x3F);
+    }
+    return codepoint;
+}
+
+GlyphAtlas::GlyphAtlas() : texture({}), solidSource({}), fallbackIndex(0) {
+    Font font = GetFontDefault();
+
+    Image fontImage = LoadImageFromTexture(font.texture);
+    ImageFormat(&fontImage, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    const Color* fontPixels = (const Color*)fontImage.data;
+
+    glyphIndex.assign(256, -1);
+    for (int i = 0; i < font.glyphCount; i++) {
+        int codepoint = font.glyphs[i].value;
+        if (codepoint >= 0 && codepoint < 256) glyphIndex[codepoint] = i;
+        if (codepoint == '?') fallbackIndex = i;
+    }
+
+    // Shelf packing: a 4x4 solid block first, then every glyph for each bucket
+    static constexpr int SOLID_SIZE = 4;
+    int x = SOLID_SIZE + GLYPH_PADDING;
+    int y = 0;
+    int rowHeight = SOLID_SIZE;
+
+    for (int b = 0; b < BUCKET_COUNT; b++) {
+        int scale = b + 1;
+        glyphs[b].resize(font.glyphCount);
+
+        for (int i = 0; i < font.glyphCount; i++) {
+            Rectangle rec = font.recs[i];
+            int w = (int)rec.width * scale;
+            int h = (int)rec.height * scale;
+
+            if (x + w > ATLAS_WIDTH) {
+                x = 0;
+                y += rowHeight + GLYPH_PADDING;
+                rowHeight = 0;
+            }
+
+            float advance = font.glyphs[i].advanceX != 0 ? (float)font.glyphs[i].advanceX : rec.width;
+            glyphs[b][i] = {
+                { (float)x, (float)y, (float)w, (float)h },
+                (float)(font.glyphs[i].offsetX * scale),
+                (float)(font.glyphs[i].offsetY * scale),
+                advance * scale
+            };
+
+            x += w + GLYPH_PADDING;
+            rowHeight = std::max(rowHeight, h);
+        }
+    }
+    int atlasHeight = y + rowHeight;
+
+    // Copy glyphs, each source pixel becomes a scale x scale block
+    Image atlas = GenImageColor(ATLAS_WIDTH, atlasHeight, BLANK);
+    Color* atlasPixels = (Color*)atlas.data;
+
+    for (int py = 0; py < SOLID_SIZE; py++) {
+        for (int px = 0; px < SOLID_SIZE; px++) {
+            atlasPixels[py * ATLAS_WIDTH + px] = WHITE;
+        }
+    }
+    // Sample the middle of the block only, clear of neighbouring texels
+    solidSource = { 1, 1, SOLID_SIZE - 2, SOLID_SIZE - 2 };
+
+    for (int b = 0; b < BUCKET_COUNT; b++) {
+        int scale = b + 1;
+        for (int i = 0; i < font.glyphCount; i++) {
+            Rectangle rec = font.recs[i];
+            Rectangle dst = glyphs[b][i].source;
+
+            for (int py = 0; py < (int)dst.height; py++) {
+                int sy = (int)rec.y + py / scale;
+                for (int px = 0; px < (int)dst.width; px++) {
+                    int sx = (int)rec.x + px / scale;
+                    atlasPixels[((int)dst.y + py) * ATLAS_WIDTH + (int)dst.x + px] =
+                        fontPixels[sy * fontImage.width + sx];
+                }
+            }
+        }
+    }
+    UnloadImage(fontImage);
+
+    texture = LoadTextureFromImage(atlas);
+    image = std::shared_ptr<const Image>(new Image(atlas), [](const Image* img) {
+        UnloadImage(*img);
+        delete img;
+    });
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    UnloadTexture(texture);
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::GetGlyph(int bucket, int codepoint) const {
+    int index = codepoint >= 0 && codepoint < 256 ? glyphIndex[codepoint] : -1;
+    return glyphs[bucket][index >= 0 ? index : fallbackIndex];
+}
+
+TextExtent GlyphAtlas::LayoutText(const std::string& text, int bucket, Vector2 origin, Color color,
+                                  std::vector<GlyphQuad>& out) const {
+    bucket = std::clamp(bucket, 0, BUCKET_COUNT - 1);
+    float spacing = (float)(bucket + 1); // same as DrawText
+    float lineHeight = (float)GetLineHeight(bucket);
+
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+
+    size_t i = 0;
+    while (i < text.size()) {
+        int codepoint = NextCodepoint(text, i);
+        if (codepoint == '\n') {
+            x = 0.0f;
+            y += lineHeight;
+            continue;
+        }
+
+        const Glyph& glyph = GetGlyph(bucket, codepoint);
+        if (codepoint != ' ') {
+            out.push_back({
+                { origin.x + x + glyph.offsetX, origin.y + y + glyph.offsetY,
+                  glyph.source.width, glyph.source.height },
+                glyph.source,
+                color
+            });
+        }
+        x += glyph.advance + spacing;
+        width = std::max(width, x);
+    }
+
+    return { { width, y + (float)GetFontSize(bucket) }, { x, y } };
+}
+
+GlyphQuad GlyphAtlas::MakeSolidQuad(Rectangle dest, Color color) const {
+    return { dest, solidSource, color };
+}
+
+void GlyphAtlas::DrawQuads(const std::vector<GlyphQuad>& quads, Vector2 offset) const {
+    float tw = (float)texture.width;
+    float th = (float)texture.height;
+
+    // Same texture and mode for every quad, so raylib keeps appending to one
+    // draw call. Chunks only make room in the batch buffer ahead of time.
+    for (size_t first = 0; first < quads.size(); first += QUADS_PER_CHUNK) {
+        size_t last = std::min(first + QUADS_PER_CHUNK, quads.size());
+        rlCheckRenderBatchLimit((int)(last - first) * 4);
+
+        rlSetTexture(texture.id);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        for (size_t i = first; i < last; i++) {
+            const GlyphQuad& q = quads[i];
+            float x0 = offset.x + q.dest.x;
+            float y0 = offset.y + q.dest.y;
+            float x1 = x0 + q.dest.width;
+            float y1 = y0 + q.dest.height;
+            float u0 = q.source.x / tw;
+            float v0 = q.source.y / th;
+            float u1 = (q.source.x + q.source.width) / tw;
+            float v1 = (q.source.y + q.source.height) / th;
+
+            rlColor4ub(q.color.r, q.color.g, q.color.b, q.color.a);
+            rlTexCoord2f(u0, v0); rlVertex2f(x0, y0);
+            rlTexCoord2f(u0, v1); rlVertex2f(x0, y1);
+            rlTexCoord2f(u1, v1); rlVertex2f(x1, y1);
+            rlTexCoord2f(u1, v0); rlVertex2f(x1, y0);
+        }
+        rlEnd();
+        rlSetTexture(0);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <raylib.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Textured quad from the glyph atlas (glyph or note background)
+struct GlyphQuad {
+    Rectangle dest;
+    Rectangle source;
+    Color color;
+};
+
+// Result of laying out a piece of text
+struct TextExtent {
+    Vector2 size;  // widest line x all lines
+    Vector2 caret; // position after the last character, relative to origin
+};
+
+// All glyphs of the default font, pre-scaled to a few integer sizes
+// and packed into one texture. Built once, text drawn from it is pixel
+// exact and every quad shares the same texture.
+class GlyphAtlas {
+public:
+    static constexpr int BUCKET_COUNT = 4;
+    static constexpr int BASE_SIZE = 10; // bucket b is (b + 1) * BASE_SIZE px
+
+    GlyphAtlas();
+    ~GlyphAtlas();
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    static int GetFontSize(int bucket) { return (bucket + 1) * BASE_SIZE; }
+    static int GetLineHeight(int bucket) { return (bucket + 1) * (BASE_SIZE + 2); }
+
+    // Append quads for UTF-8 text with its top left corner at origin
+    TextExtent LayoutText(const std::string& text, int bucket, Vector2 origin, Color color,
+                       std::vector<GlyphQuad>& out) const;
+
+    // Solid rectangle drawn from the atlas, so it joins the same batch
+    GlyphQuad MakeSolidQuad(Rectangle dest, Color color) const;
+
+    // Add quads to raylib's current batch, consecutive calls share one draw call
+    void DrawQuads(const std::vector<GlyphQuad>& quads, Vector2 offset) const;
+
+    Texture2D GetTexture() const { return texture; }
+    // CPU copy of the atlas (RGBA), used by the scaled export
+    std::shared_ptr<const Image> GetImage() const { return image; }
+
+private:
+    struct Glyph {
+        Rectangle source;
+        float offsetX;
+        float offsetY;
+        float advance;
+    };
+
+    Texture2D texture;
+    std::shared_ptr<const Image> image;
+    Rectangle solidSource;
+
+    std::vector<Glyph> glyphs[BUCKET_COUNT];
+    std::vector<int> glyphIndex; // codepoint -> glyph, for codepoints < 256
+    int fallbackIndex;
+
+    static constexpr int ATLAS_WIDTH = 1024;
+    static constexpr int GLYPH_PADDING = 1;
+    static constexpr size_t QUADS_PER_CHUNK = 256;
+
+    const Glyph& GetGlyph(int bucket, int codepoint) const;
+};
@@ -0,0 +1,64 @@
+#include "IndexedImage.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+static uint32_t PackColor(Color color) {
+    uint32_t packed;
+    std::memcpy(&packed, &color, sizeof(packed));
+    return packed;
+}
+
+bool IndexImage(const Image& image, const Color* palette, int paletteSize, IndexedImage& out) {
+    if (image.data == nullptr || image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return false;
+    if (paletteSize <= 0 || paletteSize > MAX_INDEXED_COLORS) return false;
+
+    // Unused slots repeat the first color, lowest index wins below
+    std::array<uint32_t, MAX_INDEXED_COLORS> packed;
+    packed.fill(PackColor(palette[0]));
+    for (int k = 0; k < paletteSize; k++) {
+        packed[k] = PackColor(palette[k]);
+    }
+
+    size_t count = (size_t)image.width * (size_t)image.height;
+    const unsigned char* src = (const unsigned char*)image.data;
+    out.indices.resize(count);
+    unsigned char* indices = out.indices.data();
+
+    // Branch-free loops over fixed-size tables, vectorized by the compiler
+    unsigned char missing = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t pixel;
+        std::memcpy(&pixel, src + i * 4, sizeof(pixel));
+
+        unsigned char index = 0xFF;
+        for (int k = MAX_INDEXED_COLORS - 1; k >= 0; k--) {
+            index = pixel == packed[k] ? (unsigned char)k : index;
+        }
+        indices[i] = index;
+        missing |= (unsigned char)(index == 0xFF);
+    }
+    if (missing) return false;
+
+    out.width = image.width;
+    out.height = image.height;
+    return true;
+}
+
+void ExpandIndexedImage(const IndexedImage& indexed, const Color* palette, int paletteSize, unsigned char* out) {
+    if (out == nullptr) return;
+
+    // Out of range indices expand to transparent black
+    std::array<uint32_t, 256> table = {};
+    for (int k = 0; k < paletteSize && k < MAX_INDEXED_COLORS; k++) {
+        table[k] = PackColor(palette[k]);
+    }
+
+    size_t count = indexed.indices.size();
+    const unsigned char* src = indexed.indices.data();
+    unsigned char* dst = out;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t pixel = table[src[i]];
+        std::memcpy(dst + i * 4, &pixel, sizeof(pixel));
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <raylib.h>
+#include <vector>
+
+// Pixels stored as 8-bit palette indices (one byte per pixel)
+struct IndexedImage {
+    std::vector<unsigned char> indices;
+    int width = 0;
+    int height = 0;
+};
+
+constexpr int MAX_INDEXED_COLORS = 16;
+
+// Convert an RGBA image to palette indices, reusing the capacity of out.indices.
+// Returns false if a pixel is not in the palette (out is then unusable).
+bool IndexImage(const Image& image, const Color* palette, int paletteSize, IndexedImage& out);
+
+// Convert palette indices back to RGBA, out must hold width * height * 4 bytes.
+// Rows keep their order.
+void ExpandIndexedImage(const IndexedImage& indexed, const Color* palette, int paletteSize, unsigned char* out);
@@ -0,0 +1,34 @@
+#include "PixelBufferPool.h"
+#include <utility>
+
+PixelBufferPool::PixelBufferPool() {
+    freeBuffers.reserve(MAX_FREE_BUFFERS);
+}
+
+std::vector<unsigned char> PixelBufferPool::Acquire(size_t size) {
+    // Smallest free buffer that fits. Much larger ones are left alone, so a
+    // full-frame RGBA buffer does not end up held as a 1 byte per pixel one.
+    size_t best = freeBuffers.size();
+    for (size_t i = 0; i < freeBuffers.size(); i++) {
+        size_t capacity = freeBuffers[i].capacity();
+        if (capacity >= size && capacity <= 2 * size &&
+            (best == freeBuffers.size() || freeBuffers[i].capacity() < freeBuffers[best].capacity())) {
+            best = i;
+        }
+    }
+
+    std::vector<unsigned char> buffer;
+    if (best < freeBuffers.size()) {
+        buffer = std::move(freeBuffers[best]);
+        freeBuffers.erase(freeBuffers.begin() + best);
+    }
+    buffer.resize(size); // within capacity, no allocation
+    return buffer;
+}
+
+void PixelBufferPool::Release(std::vector<unsigned char>& buffer) {
+    if (buffer.capacity() > 0 && freeBuffers.size() < MAX_FREE_BUFFERS) {
+        freeBuffers.push_back(std::move(buffer));
+    }
+    buffer = std::vector<unsigned char>();
+}
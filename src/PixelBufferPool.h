@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Recycles pixel buffers so history and export paths
+// do not allocate a fresh full-frame buffer every time.
+class PixelBufferPool {
+public:
+    PixelBufferPool();
+
+    // Buffer of the given size, reusing a released one of at most twice the size
+    std::vector<unsigned char> Acquire(size_t size);
+    // Give a buffer back, the argument is left empty
+    void Release(std::vector<unsigned char>& buffer);
+
+private:
+    std::vector<std::vector<unsigned char>> freeBuffers;
+    static constexpr size_t MAX_FREE_BUFFERS = 8;
+};
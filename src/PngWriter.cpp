@@ -0,0 +1,458 @@
+#include "PngWriter.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// zlib stream with a single fixed-Huffman deflate block.
+// Greedy LZ77 over a 32K window, good enough for the long runs of
+// background pixels that make up most of a whiteboard.
+class Deflater {
+public:
+    Deflater();
+
+    void Write(const unsigned char* data, size_t size);
+    void Finish();
+
+    // Compressed bytes produced so far, the caller empties it
+    std::vector<unsigned char>& Output() { return out; }
+
+private:
+    static constexpr int WSIZE = 32768;
+    static constexpr int WMASK = WSIZE - 1;
+    static constexpr int MIN_MATCH = 3;
+    static constexpr int MAX_MATCH = 258;
+    static constexpr int HASH_BITS = 15;
+    static constexpr int MAX_CHAIN = 32;
+    static constexpr int MAX_INSERT = 32; // longer matches are not indexed
+
+    std::vector<unsigned char> window; // 2 * WSIZE, slides down by WSIZE
+    std::vector<int> head;
+    std::vector<int> prev;
+    int start;
+    int lookahead;
+
+    std::vector<unsigned char> out;
+    uint64_t bitBuffer;
+    int bitCount;
+
+    uint32_t adlerA;
+    uint32_t adlerB;
+
+    void Compress(bool flush);
+    void SlideWindow();
+    int Hash(int pos) const;
+    void InsertHash(int pos);
+
+    void PutBits(uint32_t value, int count);
+    void PutSymbol(int symbol);
+    void PutMatch(int length, int distance);
+    void UpdateAdler(const unsigned char* data, size_t size);
+};
+
+static const int LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const int LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const int DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const int DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static uint32_t ReverseBits(uint32_t code, int length) {
+    uint32_t result = 0;
+    for (int i = 0; i < length; i++) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
+
+// Fixed Huffman codes (RFC 1951, 3.2.6), bit-reversed for LSB-first output
+struct FixedCodes {
+    std::array<uint16_t, 288> literalCode;
+    std::array<uint8_t, 288> literalLength;
+    std::array<uint8_t, 30> distanceCode;
+    std::array<uint8_t, 259> lengthIndex; // match length -> LENGTH_BASE index
+
+    FixedCodes() {
+        for (int symbol = 0; symbol < 288; symbol++) {
+            uint32_t code;
+            int length;
+            if (symbol <= 143) {
+                code = 0x30 + symbol;
+                length = 8;
+            } else if (symbol <= 255) {
+                code = 0x190 + (symbol - 144);
+                length = 9;
+            } else if (symbol <= 279) {
+                code = symbol - 256;
+                length = 7;
+            } else {
+                code = 0xC0 + (symbol - 280);
+                length = 8;
+            }
+            literalCode[symbol] = (uint16_t)ReverseBits(code, length);
+            literalLength[symbol] = (uint8_t)length;
+        }
+        for (int i = 0; i < 30; i++) {
+            distanceCode[i] = (uint8_t)ReverseBits(i, 5);
+        }
+        lengthIndex.fill(0);
+        for (int i = 0; i < 29; i++) {
+            int last = std::min(LENGTH_BASE[i] + (1 << LENGTH_EXTRA[i]) - 1, 258);
+            for (int length = LENGTH_BASE[i]; length <= last; length++) {
+                lengthIndex[length] = (uint8_t)i;
+            }
+        }
+    }
+};
+
+static const FixedCodes& GetFixedCodes() {
+    static const FixedCodes codes;
+    return codes;
+}
+
+Deflater::Deflater()
+    : window(2 * WSIZE)
+    , head(1 << HASH_BITS, -1)
+    , prev(WSIZE, -1)
+    , start(0)
+    , lookahead(0)
+    , bitBuffer(0)
+    , bitCount(0)
+    , adlerA(1)
+    , adlerB(0)
+{
+    // zlib header: deflate, 32K window, no preset dictionary
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    // One final block with fixed Huffman codes
+    PutBits(1, 1);
+    PutBits(1, 2);
+}
+
+void Deflater::Write(const unsigned char* data, size_t size) {
+    UpdateAdler(data, size);
+
+    while (size > 0) {
+        if (start + lookahead == (int)window.size()) {
+            SlideWindow();
+        }
+
+        size_t space = window.size() - (size_t)(start + lookahead);
+        size_t n = std::min(space, size);
+        std::memcpy(&window[start + lookahead], data, n);
+        lookahead += (int)n;
+        data += n;
+        size -= n;
+
+        Compress(false);
+    }
+}
+
+void Deflater::Finish() {
+    Compress(true);
+
+    // End of block, pad to a byte boundary
+    PutSymbol(256);
+    if (bitCount > 0) {
+        PutBits(0, 8 - bitCount);
+    }
+
+    uint32_t adler = (adlerB << 16) | adlerA;
+    out.push_back((unsigned char)(adler >> 24));
+    out.push_back((unsigned char)(adler >> 16));
+    out.push_back((unsigned char)(adler >> 8));
+    out.push_back((unsigned char)adler);
+}
+
+void Deflater::Compress(bool flush) {
+    // Without flush, keep a full match worth of lookahead for the next write
+    while (lookahead >= MAX_MATCH || (flush && lookahead > 0)) {
+        int bestLength = 0;
+        int bestDistance = 0;
+
+        if (lookahead >= MIN_MATCH) {
+            int maxLength = std::min(lookahead, MAX_MATCH);
+            int limit = start - WSIZE;
+            int candidate = head[Hash(start)];
+            int chain = MAX_CHAIN;
+
+            while (candidate > limit && candidate >= 0 && chain-- > 0) {
+                // Quick reject on the byte that would make the match longer
+                if (window[candidate + bestLength] == window[start + bestLength]) {
+                    int length = 0;
+                    while (length < maxLength && window[candidate + length] == window[start + length]) {
+                        length++;
+                    }
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = start - candidate;
+                        if (length == maxLength) break;
+                    }
+                }
+
+                int next = prev[candidate & WMASK];
+                if (next >= candidate) break;
+                candidate = next;
+            }
+
+            InsertHash(start);
+        }
+
+        if (bestLength >= MIN_MATCH) {
+            PutMatch(bestLength, bestDistance);
+
+            if (bestLength <= MAX_INSERT) {
+                for (int i = 1; i < bestLength; i++) {
+                    if (lookahead - i >= MIN_MATCH) {
+                        InsertHash(start + i);
+                    }
+                }
+            }
+            start += bestLength;
+            lookahead -= bestLength;
+        } else {
+            PutSymbol(window[start]);
+            start++;
+            lookahead--;
+        }
+    }
+}
+
+void Deflater::SlideWindow() {
+    std::memmove(window.data(), window.data() + WSIZE, WSIZE);
+    start -= WSIZE;
+
+    for (auto& pos : head) {
+        pos = pos >= WSIZE ? pos - WSIZE : -1;
+    }
+    for (auto& pos : prev) {
+        pos = pos >= WSIZE ? pos - WSIZE : -1;
+    }
+}
+
+int Deflater::Hash(int pos) const {
+    uint32_t key = ((uint32_t)window[pos] << 16) | ((uint32_t)window[pos + 1] << 8) | window[pos + 2];
+    return (int)((key * 2654435761u) >> (32 - HASH_BITS));
+}
+
+void Deflater::InsertHash(int pos) {
+    int h = Hash(pos);
+    prev[pos & WMASK] = head[h];
+    head[h] = pos;
+}
+
+void Deflater::PutBits(uint32_t value, int count) {
+    bitBuffer |= (uint64_t)value << bitCount;
+    bitCount += count;
+    while (bitCount >= 8) {
+        out.push_back((unsigned char)(bitBuffer & 0xFF));
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void Deflater::PutSymbol(int symbol) {
+    const FixedCodes& codes = GetFixedCodes();
+    PutBits(codes.literalCode[symbol], codes.literalLength[symbol]);
+}
+
+void Deflater::PutMatch(int length, int distance) {
+    const FixedCodes& codes = GetFixedCodes();
+
+    int li = codes.lengthIndex[length];
+    PutSymbol(257 + li);
+    PutBits(length - LENGTH_BASE[li], LENGTH_EXTRA[li]);
+
+    int di = (int)(std::upper_bound(DIST_BASE, DIST_BASE + 30, distance) - DIST_BASE) - 1;
+    PutBits(codes.distanceCode[di], 5);
+    PutBits(distance - DIST_BASE[di], DIST_EXTRA[di]);
+}
+
+void Deflater::UpdateAdler(const unsigned char* data, size_t size) {
+    // 5552 is the largest block that cannot overflow before the modulo
+    while (size > 0) {
+        size_t n = std::min(size, (size_t)5552);
+        for (size_t i = 0; i < n; i++) {
+            adlerA += data[i];
+            adlerB += adlerA;
+        }
+        adlerA %= 65521;
+        adlerB %= 65521;
+        data += n;
+        size -= n;
+    }
+}
+
+static uint32_t Crc32(uint32_t crc, const unsigned char* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t = {};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void PutUint32(unsigned char* dst, uint32_t value) {
+    dst[0] = (unsigned char)(value >> 24);
+    dst[1] = (unsigned char)(value >> 16);
+    dst[2] = (unsigned char)(value >> 8);
+    dst[3] = (unsigned char)value;
+}
+
+// Compressed data is written out in IDAT chunks of about this size
+static constexpr size_t IDAT_SIZE = 64 * 1024;
+
+PngWriter::PngWriter()
+    : file(nullptr)
+    , width(0)
+    , height(0)
+    , bitDepth(8)
+    , rowsWritten(0)
+    , failed(false)
+{
+}
+
+PngWriter::~PngWriter() {
+    // Unfinished file is left truncated
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+bool PngWriter::OpenIndexed(const char* filename, int width, int height,
+                            const Color* palette, int paletteSize, int bitDepth) {
+    if (bitDepth != 4 && bitDepth != 8) return false;
+    if (paletteSize <= 0 || paletteSize > (1 << bitDepth)) return false;
+
+    if (!Open(filename, width, height, bitDepth, 3, 1)) return false;
+
+    std::vector<unsigned char> plte(paletteSize * 3);
+    for (int i = 0; i < paletteSize; i++) {
+        plte[i * 3 + 0] = palette[i].r;
+        plte[i * 3 + 1] = palette[i].g;
+        plte[i * 3 + 2] = palette[i].b;
+    }
+    WriteChunk("PLTE", plte.data(), plte.size());
+
+    return !failed;
+}
+
+bool PngWriter::OpenRGB(const char* filename, int width, int height) {
+    return Open(filename, width, height, 8, 2, 3);
+}
+
+bool PngWriter::Open(const char* filename, int width, int height, int bitDepth, int colorType, int channels) {
+    if (file != nullptr || width <= 0 || height <= 0) return false;
+
+    file = fopen(filename, "wb");
+    if (file == nullptr) return false;
+
+    this->width = width;
+    this->height = height;
+    this->bitDepth = bitDepth;
+    rowsWritten = 0;
+    failed = false;
+    deflater = std::make_unique<Deflater>();
+
+    // Filter byte + pixels
+    row.assign(1 + ((size_t)width * channels * bitDepth + 7) / 8, 0);
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (fwrite(signature, 1, sizeof(signature), file) != sizeof(signature)) failed = true;
+
+    unsigned char ihdr[13];
+    PutUint32(ihdr, (uint32_t)width);
+    PutUint32(ihdr + 4, (uint32_t)height);
+    ihdr[8] = (unsigned char)bitDepth;
+    ihdr[9] = (unsigned char)colorType;
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // adaptive filtering
+    ihdr[12] = 0; // no interlace
+    WriteChunk("IHDR", ihdr, sizeof(ihdr));
+
+    return !failed;
+}
+
+void PngWriter::WriteRow(const unsigned char* pixels) {
+    if (file == nullptr || rowsWritten >= height) return;
+
+    // Filter type 0 (none)
+    row[0] = 0;
+    if (bitDepth == 8) {
+        std::memcpy(&row[1], pixels, row.size() - 1);
+    } else {
+        for (int x = 0; x < width; x += 2) {
+            unsigned char hi = pixels[x] & 0x0F;
+            unsigned char lo = x + 1 < width ? pixels[x + 1] & 0x0F : 0;
+            row[1 + x / 2] = (unsigned char)((hi << 4) | lo);
+        }
+    }
+
+    deflater->Write(row.data(), row.size());
+    rowsWritten++;
+
+    FlushCompressed(false);
+}
+
+bool PngWriter::Close() {
+    if (file == nullptr) return false;
+
+    if (rowsWritten != height) failed = true;
+
+    deflater->Finish();
+    FlushCompressed(true);
+    WriteChunk("IEND", nullptr, 0);
+
+    if (fclose(file) != 0) failed = true;
+    file = nullptr;
+    deflater.reset();
+
+    return !failed;
+}
+
+void PngWriter::WriteChunk(const char* type, const unsigned char* data, size_t size) {
+    unsigned char header[8];
+    PutUint32(header, (uint32_t)size);
+    std::memcpy(header + 4, type, 4);
+
+    uint32_t crc = Crc32(0, header + 4, 4);
+    if (size > 0) {
+        crc = Crc32(crc, data, size);
+    }
+    unsigned char footer[4];
+    PutUint32(footer, crc);
+
+    if (fwrite(header, 1, 8, file) != 8) failed = true;
+    if (size > 0 && fwrite(data, 1, size, file) != size) failed = true;
+    if (fwrite(footer, 1, 4, file) != 4) failed = true;
+}
+
+void PngWriter::FlushCompressed(bool final) {
+    auto& out = deflater->Output();
+    if (out.size() >= IDAT_SIZE || (final && !out.empty())) {
+        WriteChunk("IDAT", out.data(), out.size());
+        out.clear();
+    }
+}
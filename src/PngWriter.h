@@ -0,0 +1,46 @@
+#pragma once
+
+#include <raylib.h>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+class Deflater;
+
+// Streaming PNG encoder, rows are compressed and written to the file
+// as they arrive, so the whole image never has to be in memory.
+class PngWriter {
+public:
+    PngWriter();
+    ~PngWriter();
+
+    // Indexed image with up to 16 colors (bitDepth 4) or 256 colors (bitDepth 8)
+    bool OpenIndexed(const char* filename, int width, int height,
+                     const Color* palette, int paletteSize, int bitDepth);
+
+    // 8-bit RGB image
+    bool OpenRGB(const char* filename, int width, int height);
+
+    // One row of pixels: palette indices, one byte per pixel (packed here for
+    // bitDepth 4), or RGB triplets
+    void WriteRow(const unsigned char* pixels);
+
+    // Finish the file, returns false if anything failed to write
+    bool Close();
+
+private:
+    FILE* file;
+    std::unique_ptr<Deflater> deflater;
+    int width;
+    int height;
+    int bitDepth;
+    int rowsWritten;
+    bool failed;
+
+    std::vector<unsigned char> row; // filter byte + packed pixels
+
+    bool Open(const char* filename, int width, int height, int bitDepth, int colorType, int channels);
+    void WriteChunk(const char* type, const unsigned char* data, size_t size);
+    void FlushCompressed(bool final);
+};
@@ -0,0 +1,154 @@
+#include "Stroke.h"
+#include <algorithm>
+#include <cmath>
+
+static float Distance(Vector2 a, Vector2 b) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Distance from point p to segment a-b
+static float DistanceToSegment(Vector2 p, Vector2 a, Vector2 b) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float lengthSq = dx * dx + dy * dy;
+    if (lengthSq <= 0.0f) return Distance(p, a);
+
+    float t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSq;
+    t = std::clamp(t, 0.0f, 1.0f);
+    return Distance(p, { a.x + dx * t, a.y + dy * t });
+}
+
+static Vector2 Lerp(Vector2 a, Vector2 b, float ta, float tb, float t) {
+    float wa = (tb - t) / (tb - ta);
+    float wb = (t - ta) / (tb - ta);
+    return { a.x * wa + b.x * wb, a.y * wa + b.y * wb };
+}
+
+Stroke::Stroke()
+    : tolerance(MIN_TOLERANCE)
+    , active(false)
+    , tail({0, 0})
+    , lastSample({0, 0})
+{
+}
+
+void Stroke::Begin(Vector2 point, float thickness) {
+    tolerance = std::max(MIN_TOLERANCE, thickness * TOLERANCE_PER_THICKNESS);
+
+    // clear() keeps capacity, so steady drawing does not reallocate
+    points.clear();
+    pending.clear();
+    points.push_back(point);
+    tail = point;
+    lastSample = point;
+    active = true;
+}
+
+void Stroke::AddPoint(Vector2 point) {
+    if (!active) return;
+
+    lastSample = point;
+
+    // Mouse positions are whole pixels and jitter, so slow moves follow them
+    // only part of the way. Fast moves are taken as they are, so corners
+    // are not cut.
+    float weight = std::clamp(Distance(point, tail) / JITTER_DISTANCE, SAMPLE_SMOOTHING, 1.0f);
+    point = {
+        tail.x + (point.x - tail.x) * weight,
+        tail.y + (point.y - tail.y) * weight
+    };
+
+    // Mouse did not really move
+    if (Distance(point, tail) < MIN_SAMPLE_DISTANCE) return;
+
+    // Once the line from the last kept point to the new sample no longer
+    // covers the samples in between, the previous sample becomes a kept point
+    if (!pending.empty() && (pending.size() >= MAX_PENDING || !PendingFitsLine(point))) {
+        points.push_back(pending.back());
+        pending.clear();
+    }
+
+    pending.push_back(point);
+    tail = point;
+}
+
+void Stroke::End() {
+    if (!active) return;
+
+    if (!pending.empty()) {
+        points.push_back(pending.back());
+        pending.clear();
+    }
+    // The filtered samples trail the mouse, finish where it was released
+    if (Distance(lastSample, points.back()) >= MIN_SAMPLE_DISTANCE) {
+        points.push_back(lastSample);
+    }
+    active = false;
+}
+
+size_t Stroke::GetStableSegmentCount() const {
+    if (points.size() < 2) return 0;
+
+    // A segment's curve depends on the point after it,
+    // so the last segment is only final once the stroke ended
+    return active ? points.size() - 2 : points.size() - 1;
+}
+
+bool Stroke::PendingFitsLine(Vector2 end) const {
+    Vector2 anchor = points.back();
+    for (const auto& p : pending) {
+        if (DistanceToSegment(p, anchor, end) > tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Stroke::AppendSmoothedSegment(size_t i, std::vector<Vector2>& out) const {
+    AppendSmoothedSegment(points, i, out);
+}
+
+void Stroke::AppendSmoothedSegment(const std::vector<Vector2>& points, size_t i, std::vector<Vector2>& out) {
+    if (i + 1 >= points.size()) return;
+
+    Vector2 p0 = i > 0 ? points[i - 1] : points[i];
+    Vector2 p1 = points[i];
+    Vector2 p2 = points[i + 1];
+    Vector2 p3 = i + 2 < points.size() ? points[i + 2] : points[i + 1];
+
+    float length = Distance(p1, p2);
+    int steps = std::clamp((int)(length / 12.0f), 1, 8);
+
+    // Centripetal Catmull-Rom (no loops or overshoot on uneven spacing)
+    auto knot = [](Vector2 a, Vector2 b) {
+        float d = std::sqrt(Distance(a, b));
+        return d > 1e-4f ? d : 1.0f;
+    };
+    float t0 = 0.0f;
+    float t1 = t0 + knot(p0, p1);
+    float t2 = t1 + knot(p1, p2);
+    float t3 = t2 + knot(p2, p3);
+
+    for (int s = 1; s < steps; s++) {
+        float t = t1 + (t2 - t1) * (float)s / (float)steps;
+
+        Vector2 a1 = Lerp(p0, p1, t0, t1, t);
+        Vector2 a2 = Lerp(p1, p2, t1, t2, t);
+        Vector2 a3 = Lerp(p2, p3, t2, t3, t);
+        Vector2 b1 = Lerp(a1, a2, t0, t2, t);
+        Vector2 b2 = Lerp(a2, a3, t1, t3, t);
+        out.push_back(Lerp(b1, b2, t1, t2, t));
+    }
+    out.push_back(p2);
+}
+
+void Stroke::Smooth(const std::vector<Vector2>& points, std::vector<Vector2>& out) {
+    if (points.empty()) return;
+
+    out.push_back(points[0]);
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        AppendSmoothedSegment(points, i, out);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <raylib.h>
+#include <cstddef>
+#include <vector>
+
+// Freehand stroke that simplifies mouse samples as they arrive.
+// Samples are low-passed to remove mouse jitter, then only points that bend
+// the path by more than the tolerance are kept; the kept points are smoothed
+// with a Catmull-Rom curve for drawing.
+class Stroke {
+public:
+    Stroke();
+
+    // Tolerance grows with the thickness, a thick line hides small bends
+    void Begin(Vector2 point, float thickness);
+    void AddPoint(Vector2 point);
+    void End();
+
+    bool IsActive() const { return active; }
+
+    // Simplified points (the pending tail is added by End)
+    const std::vector<Vector2>& GetPoints() const { return points; }
+    // Latest filtered sample, not yet part of the simplified points
+    Vector2 GetTail() const { return tail; }
+
+    // Number of segments whose curve no longer changes as points are added
+    size_t GetStableSegmentCount() const;
+
+    // Append the smoothed polyline of segment i (points[i] -> points[i + 1]).
+    // The start point is not included, so consecutive segments chain up.
+    void AppendSmoothedSegment(size_t i, std::vector<Vector2>& out) const;
+    static void AppendSmoothedSegment(const std::vector<Vector2>& points, size_t i, std::vector<Vector2>& out);
+
+    // Smooth a whole point list into a polyline
+    static void Smooth(const std::vector<Vector2>& points, std::vector<Vector2>& out);
+
+private:
+    float tolerance;
+    bool active;
+
+    std::vector<Vector2> points;  // committed, simplified points
+    std::vector<Vector2> pending; // filtered samples since the last committed point
+    Vector2 tail;
+    Vector2 lastSample; // unfiltered, where the stroke ends
+
+    static constexpr size_t MAX_PENDING = 64;
+    static constexpr float MIN_SAMPLE_DISTANCE = 0.5f;
+    static constexpr float MIN_TOLERANCE = 1.5f;           // pixels, above mouse quantization
+    static constexpr float TOLERANCE_PER_THICKNESS = 0.25f;
+    static constexpr float SAMPLE_SMOOTHING = 0.35f;       // weight of a new sample on slow moves
+    static constexpr float JITTER_DISTANCE = 8.0f;         // pixels, longer steps are not filtered
+
+    bool PendingFitsLine(Vector2 end) const;
+};
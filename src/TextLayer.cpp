@@ -0,0 +1,150 @@
+#include "TextLayer.h"
+#include <algorithm>
+#include <cmath>
+
+TextLayer::TextLayer(const GlyphAtlas& atlas)
+    : atlas(atlas)
+    , activeNote(-1)
+{
+}
+
+void TextLayer::AddNote(Vector2 position, Color color, int bucket, bool sticky) {
+    Deselect();
+
+    TextNote note;
+    // Whole pixels keep the pre-scaled glyphs sharp
+    note.position = { std::round(position.x), std::round(position.y) };
+    note.color = color;
+    note.bucket = std::clamp(bucket, 0, GlyphAtlas::BUCKET_COUNT - 1);
+    note.sticky = sticky;
+    Layout(note);
+
+    notes.push_back(std::move(note));
+    activeNote = (int)notes.size() - 1;
+    RebuildQuads();
+}
+
+bool TextLayer::SelectNoteAt(Vector2 point) {
+    int hit = -1;
+    for (int i = (int)notes.size() - 1; i >= 0 && hit < 0; i--) {
+        if (CheckCollisionPointRec(point, notes[i].bounds)) hit = i;
+    }
+    if (hit < 0) return false;
+
+    if (hit != activeNote) {
+        // Deselect may remove an empty note in front of the hit one
+        int previous = activeNote;
+        size_t count = notes.size();
+        Deselect();
+        if (notes.size() < count && previous < hit) hit--;
+        activeNote = hit;
+    }
+    return true;
+}
+
+void TextLayer::Deselect() {
+    if (activeNote < 0) return;
+
+    if (notes[activeNote].text.empty()) {
+        notes.erase(notes.begin() + activeNote);
+        RebuildQuads();
+    }
+    activeNote = -1;
+}
+
+void TextLayer::HandleTyping() {
+    if (activeNote < 0) return;
+    TextNote& note = notes[activeNote];
+    bool changed = false;
+
+    int codepoint = GetCharPressed();
+    while (codepoint > 0) {
+        int size = 0;
+        const char* utf8 = CodepointToUTF8(codepoint, &size);
+        note.text.append(utf8, size);
+        changed = true;
+        codepoint = GetCharPressed();
+    }
+
+    if ((IsKeyPressed(KEY_BACKSPACE) || IsKeyPressedRepeat(KEY_BACKSPACE)) && !note.text.empty()) {
+        // Drop continuation bytes, then the lead byte of the last codepoint
+        while (note.text.size() > 1 && ((unsigned char)note.text.back() & 0xC0) == 0x80) {
+            note.text.pop_back();
+        }
+        note.text.pop_back();
+        changed = true;
+    }
+
+    // Ctrl+Enter commits, handled by the editor
+    bool ctrl = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    if (IsKeyPressed(KEY_ENTER) && !ctrl) {
+        note.text += '\n';
+        changed = true;
+    }
+
+    if (changed) {
+        Layout(note);
+        RebuildQuads();
+    }
+
+    if (IsKeyPressed(KEY_ESCAPE)) {
+        Deselect();
+    }
+}
+
+void TextLayer::Draw(Vector2 offset) const {
+    atlas.DrawQuads(quads, offset);
+}
+
+void TextLayer::DrawEditingMarks(Vector2 offset) const {
+    if (activeNote < 0) return;
+    const TextNote& note = notes[activeNote];
+
+    Rectangle outline = { note.bounds.x + offset.x - 2, note.bounds.y + offset.y - 2,
+                          note.bounds.width + 4, note.bounds.height + 4 };
+    DrawRectangleLinesEx(outline, 1, GRAY);
+
+    // Blinking caret after the last character
+    if (std::fmod(GetTime(), 1.0) < 0.5) {
+        float padding = note.sticky ? NOTE_PADDING : 0.0f;
+        float x = offset.x + note.position.x + padding + note.caret.x;
+        float y = offset.y + note.position.y + padding + note.caret.y;
+        float h = (float)GlyphAtlas::GetFontSize(note.bucket);
+        DrawRectangleRec({ x, y, 1.0f + note.bucket, h }, note.sticky ? BLACK : note.color);
+    }
+}
+
+void TextLayer::Clear() {
+    notes.clear();
+    quads.clear();
+    activeNote = -1;
+}
+
+void TextLayer::Layout(TextNote& note) const {
+    note.quads.clear();
+
+    float padding = note.sticky ? NOTE_PADDING : 0.0f;
+    Vector2 origin = { note.position.x + padding, note.position.y + padding };
+
+    // Background first, so it is drawn under the text of the same note
+    if (note.sticky) note.quads.push_back(atlas.MakeSolidQuad({}, note.color));
+
+    TextExtent extent = atlas.LayoutText(note.text, note.bucket, origin,
+                                         note.sticky ? BLACK : note.color, note.quads);
+    note.caret = extent.caret;
+
+    // Empty notes still need an area to click on
+    float minSize = (float)GlyphAtlas::GetFontSize(note.bucket);
+    note.bounds = { note.position.x, note.position.y,
+                    std::max(extent.size.x, minSize) + 2 * padding,
+                    std::max(extent.size.y, minSize) + 2 * padding };
+
+    if (note.sticky) note.quads[0].dest = note.bounds;
+}
+
+void TextLayer::RebuildQuads() {
+    quads.clear();
+    for (const TextNote& note : notes) {
+        quads.insert(quads.end(), note.quads.begin(), note.quads.end());
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <raylib.h>
+#include <string>
+#include <vector>
+#include "GlyphAtlas.h"
+
+// Typed label or sticky note, stays editable until committed to the canvas
+struct TextNote {
+    Vector2 position; // canvas coordinates, whole pixels
+    std::string text;
+    Color color;
+    int bucket;  // GlyphAtlas size bucket
+    bool sticky; // filled background in the note color, black text
+
+    std::vector<GlyphQuad> quads; // laid out once per edit, not per frame
+    Rectangle bounds;
+    Vector2 caret;
+};
+
+// Text objects drawn on top of the canvas. Quads of all notes are kept in
+// one list, so a frame draws every note with a single batched call.
+class TextLayer {
+public:
+    explicit TextLayer(const GlyphAtlas& atlas);
+
+    // New note at position, becomes the one being edited
+    void AddNote(Vector2 position, Color color, int bucket, bool sticky);
+
+    // Start editing the topmost note under point, returns false if none
+    bool SelectNoteAt(Vector2 point);
+
+    // Stop editing, an empty note is removed
+    void Deselect();
+
+    bool IsEditing() const { return activeNote >= 0; }
+
+    // Keyboard input for the note being edited
+    void HandleTyping();
+
+    void Draw(Vector2 offset) const;
+    void DrawEditingMarks(Vector2 offset) const;
+
+    bool IsEmpty() const { return notes.empty(); }
+    const std::vector<GlyphQuad>& GetQuads() const { return quads; }
+    void Clear();
+
+private:
+    const GlyphAtlas& atlas;
+    std::vector<TextNote> notes;
+    std::vector<GlyphQuad> quads; // all notes, in drawing order
+    int activeNote; // -1 when not editing
+
+    static constexpr float NOTE_PADDING = 6.0f;
+
+    void Layout(TextNote& note) const;
+    void RebuildQuads();
+};
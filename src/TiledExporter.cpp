@@ -0,0 +1,506 @@
+#include "TiledExporter.h"
+#include "IndexedImage.h"
+#include "PngWriter.h"
+#include "Stroke.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+// Part of a tile that a command may write to, in output pixels (inclusive)
+struct TileTarget {
+    Color* pixels;
+    int stride;
+    int originX, originY;
+    int x0, y0, x1, y1;
+
+    Color& At(int x, int y) const {
+        return pixels[(size_t)(y - originY) * stride + (x - originX)];
+    }
+};
+
+static bool SameColor(Color a, Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static bool ContainsColor(const std::vector<Color>& colors, Color color) {
+    for (const auto& c : colors) {
+        if (SameColor(c, color)) return true;
+    }
+    return false;
+}
+
+// Alpha blend c over dst, like raylib's default blend mode
+static void BlendPixel(Color& dst, Color c) {
+    if (c.a == 255) {
+        dst = c;
+    } else if (c.a > 0) {
+        int a = c.a;
+        dst.r = (unsigned char)((c.r * a + dst.r * (255 - a)) / 255);
+        dst.g = (unsigned char)((c.g * a + dst.g * (255 - a)) / 255);
+        dst.b = (unsigned char)((c.b * a + dst.b * (255 - a)) / 255);
+    }
+}
+
+// Fill the pixels of row y whose centers lie in [left, right]
+static void FillSpan(const TileTarget& t, int y, float left, float right, Color color) {
+    int x0 = std::max(t.x0, (int)std::ceil(left - 0.5f));
+    int x1 = std::min(t.x1, (int)std::floor(right - 0.5f));
+    if (x0 > x1) return;
+
+    Color* row = &t.At(x0, y);
+    std::fill(row, row + (x1 - x0 + 1), color);
+}
+
+// Narrow [lo, hi] to the x where smin <= c1 * x + c0 <= smax
+static void ClipInterval(float& lo, float& hi, float c1, float c0, float smin, float smax) {
+    if (std::abs(c1) < 1e-6f) {
+        if (c0 < smin || c0 > smax) {
+            lo = INFINITY;
+            hi = -INFINITY;
+        }
+        return;
+    }
+    float x1 = (smin - c0) / c1;
+    float x2 = (smax - c0) / c1;
+    if (x1 > x2) std::swap(x1, x2);
+    lo = std::max(lo, x1);
+    hi = std::min(hi, x2);
+}
+
+// Atlas quad sampled with nearest lookup and tinted by the quad color,
+// same as drawing it through rlgl at 1x
+static void FillQuad(const TileTarget& t, const GlyphQuad& quad, const Image& atlas, float scale) {
+    if (quad.dest.width <= 0 || quad.dest.height <= 0) return;
+
+    int x0 = std::max(t.x0, (int)std::ceil(quad.dest.x * scale));
+    int y0 = std::max(t.y0, (int)std::ceil(quad.dest.y * scale));
+    int x1 = std::min(t.x1, (int)std::ceil((quad.dest.x + quad.dest.width) * scale) - 1);
+    int y1 = std::min(t.y1, (int)std::ceil((quad.dest.y + quad.dest.height) * scale) - 1);
+    if (x0 > x1 || y0 > y1) return;
+
+    const Color* texels = (const Color*)atlas.data;
+    float stepX = quad.source.width / (quad.dest.width * scale);
+    float stepY = quad.source.height / (quad.dest.height * scale);
+
+    for (int y = y0; y <= y1; y++) {
+        int sy = (int)quad.source.y + std::min((int)((y + 0.5f - quad.dest.y * scale) * stepY),
+                                               (int)quad.source.height - 1);
+        const Color* srcRow = texels + (size_t)sy * atlas.width + (int)quad.source.x;
+        for (int x = x0; x <= x1; x++) {
+            int sx = std::min((int)((x + 0.5f - quad.dest.x * scale) * stepX), (int)quad.source.width - 1);
+            Color c = srcRow[sx];
+            c.r = (unsigned char)(c.r * quad.color.r / 255);
+            c.g = (unsigned char)(c.g * quad.color.g / 255);
+            c.b = (unsigned char)(c.b * quad.color.b / 255);
+            c.a = (unsigned char)(c.a * quad.color.a / 255);
+            BlendPixel(t.At(x, y), c);
+        }
+    }
+}
+
+// Thick line with round caps, filled one row span at a time
+static void FillCapsule(const TileTarget& t, Vector2 a, Vector2 b, float radius, Color color) {
+    int y0 = std::max(t.y0, (int)std::floor(std::min(a.y, b.y) - radius));
+    int y1 = std::min(t.y1, (int)std::ceil(std::max(a.y, b.y) + radius));
+
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float length = std::sqrt(dx * dx + dy * dy);
+    float radiusSq = radius * radius;
+
+    for (int y = y0; y <= y1; y++) {
+        float py = (float)y + 0.5f;
+
+        // The capsule is convex, so each row is one span:
+        // the union of both end caps and the band along the segment
+        float left = INFINITY;
+        float right = -INFINITY;
+        for (Vector2 c : { a, b }) {
+            float ey = py - c.y;
+            float h = radiusSq - ey * ey;
+            if (h >= 0.0f) {
+                float w = std::sqrt(h);
+                left = std::min(left, c.x - w);
+                right = std::max(right, c.x + w);
+            }
+        }
+        if (length > 0.0f) {
+            float ux = dx / length;
+            float uy = dy / length;
+            float lo = -INFINITY;
+            float hi = INFINITY;
+            // Distance across the segment, then position along it
+            ClipInterval(lo, hi, -uy, a.x * uy + (py - a.y) * ux, -radius, radius);
+            ClipInterval(lo, hi, ux, -a.x * ux + (py - a.y) * uy, 0.0f, length);
+            if (lo <= hi) {
+                left = std::min(left, lo);
+                right = std::max(right, hi);
+            }
+        }
+
+        if (left <= right) {
+            FillSpan(t, y, left, right, color);
+        }
+    }
+}
+
+// Disc (inner <= 0) or ring around center, filled one row span at a time
+static void FillRing(const TileTarget& t, Vector2 center, float inner, float outer, Color color) {
+    int y0 = std::max(t.y0, (int)std::floor(center.y - outer));
+    int y1 = std::min(t.y1, (int)std::ceil(center.y + outer));
+
+    for (int y = y0; y <= y1; y++) {
+        float ey = (float)y + 0.5f - center.y;
+        float outerH = outer * outer - ey * ey;
+        if (outerH < 0.0f) continue;
+        float wo = std::sqrt(outerH);
+
+        float innerH = inner > 0.0f ? inner * inner - ey * ey : -1.0f;
+        if (innerH <= 0.0f) {
+            FillSpan(t, y, center.x - wo, center.x + wo, color);
+        } else {
+            float wi = std::sqrt(innerH);
+            FillSpan(t, y, center.x - wo, center.x - wi, color);
+            FillSpan(t, y, center.x + wi, center.x + wo, color);
+        }
+    }
+}
+
+TiledExporter::TiledExporter(const DrawCommand* commands, size_t count, const Vector2* points,
+                             int width, int height, const std::vector<Color>& palette)
+    : commands(commands)
+    , count(count)
+    , points(points)
+    , width(width)
+    , height(height)
+    , palette(palette)
+    , scale(1)
+{
+}
+
+bool TiledExporter::Export(const char* filename, int scale) {
+    if (scale < 1 || width <= 0 || height <= 0) return false;
+
+    this->scale = scale;
+    Prepare();
+
+    int outW = width * scale;
+    int outH = height * scale;
+    bool indexed = UsesPaletteOnly();
+
+    PngWriter writer;
+    bool opened = indexed
+        ? writer.OpenIndexed(filename, outW, outH, palette.data(), (int)palette.size(), 4)
+        : writer.OpenRGB(filename, outW, outH);
+    if (!opened) return false;
+
+    int tilesX = (outW + TILE_SIZE - 1) / TILE_SIZE;
+    int bandCount = (outH + TILE_SIZE - 1) / TILE_SIZE;
+    int threadCount = std::clamp((int)std::thread::hardware_concurrency(), 1, tilesX);
+
+    // Two bands: one being drawn by the workers, one being compressed
+    std::vector<Color> bands[2];
+    bands[0].resize((size_t)outW * TILE_SIZE);
+    bands[1].resize((size_t)outW * TILE_SIZE);
+    std::atomic<int> nextTile[2];
+    std::vector<std::thread> workers;
+
+    auto startBand = [&](int band) {
+        Color* pixels = bands[band % 2].data();
+        std::atomic<int>* next = &nextTile[band % 2];
+        *next = 0;
+
+        int tileY = band * TILE_SIZE;
+        int tileH = std::min(TILE_SIZE, outH - tileY);
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back([this, pixels, next, tileY, tileH, tilesX, outW] {
+                // Workers take the next free tile until the band is done
+                for (int t = (*next)++; t < tilesX; t = (*next)++) {
+                    int tileX = t * TILE_SIZE;
+                    int tileW = std::min(TILE_SIZE, outW - tileX);
+                    RenderTile(tileX, tileY, tileW, tileH, pixels + tileX, outW);
+                }
+            });
+        }
+    };
+    auto joinWorkers = [&] {
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    };
+
+    std::vector<unsigned char> row((size_t)outW * (indexed ? 1 : 3));
+    startBand(0);
+
+    for (int band = 0; band < bandCount; band++) {
+        joinWorkers();
+        if (band + 1 < bandCount) {
+            startBand(band + 1);
+        }
+
+        const std::vector<Color>& pixels = bands[band % 2];
+        int bandH = std::min(TILE_SIZE, outH - band * TILE_SIZE);
+        for (int y = 0; y < bandH; y++) {
+            const Color* src = &pixels[(size_t)y * outW];
+            if (indexed) {
+                // Rows are mostly long runs, look up only when the color changes
+                Color last = palette[0];
+                unsigned char lastIndex = 0;
+                for (int x = 0; x < outW; x++) {
+                    if (!SameColor(src[x], last)) {
+                        last = src[x];
+                        lastIndex = 0;
+                        for (size_t k = 0; k < palette.size(); k++) {
+                            if (SameColor(last, palette[k])) {
+                                lastIndex = (unsigned char)k;
+                                break;
+                            }
+                        }
+                    }
+                    row[x] = lastIndex;
+                }
+            } else {
+                for (int x = 0; x < outW; x++) {
+                    row[(size_t)x * 3 + 0] = src[x].r;
+                    row[(size_t)x * 3 + 1] = src[x].g;
+                    row[(size_t)x * 3 + 2] = src[x].b;
+                }
+            }
+            writer.WriteRow(row.data());
+        }
+    }
+    joinWorkers();
+
+    return writer.Close();
+}
+
+void TiledExporter::Prepare() {
+    prepared.clear();
+    prepared.reserve(count);
+
+    float s = (float)scale;
+    int outW = width * scale;
+    int outH = height * scale;
+
+    for (size_t i = 0; i < count; i++) {
+        const DrawCommand& command = commands[i];
+        const Vector2* commandPoints = points + command.firstPoint;
+
+        PreparedCommand pc = {};
+        pc.command = &command;
+        pc.minX = 0;
+        pc.minY = 0;
+        pc.maxX = outW - 1;
+        pc.maxY = outH - 1;
+
+        switch (command.type) {
+            case DrawCommand::Type::STROKE: {
+                if (command.pointCount == 0) continue;
+
+                std::vector<Vector2> scaled;
+                scaled.reserve(command.pointCount);
+                for (size_t k = 0; k < command.pointCount; k++) {
+                    scaled.push_back({ commandPoints[k].x * s, commandPoints[k].y * s });
+                }
+                Stroke::Smooth(scaled, pc.path);
+                pc.radius = std::max(command.size * s / 2.0f, 0.5f);
+
+                float minX = pc.path[0].x, maxX = pc.path[0].x;
+                float minY = pc.path[0].y, maxY = pc.path[0].y;
+                for (const auto& p : pc.path) {
+                    minX = std::min(minX, p.x);
+                    maxX = std::max(maxX, p.x);
+                    minY = std::min(minY, p.y);
+                    maxY = std::max(maxY, p.y);
+                }
+                pc.minX = (int)std::floor(minX - pc.radius);
+                pc.maxX = (int)std::ceil(maxX + pc.radius);
+                pc.minY = (int)std::floor(minY - pc.radius);
+                pc.maxY = (int)std::ceil(maxY + pc.radius);
+                break;
+            }
+            case DrawCommand::Type::RECTANGLE: {
+                if (command.pointCount < 2) continue;
+
+                // Same integer rectangle as DrawRectangleShape
+                Vector2 a = commandPoints[0];
+                Vector2 b = commandPoints[1];
+                int x = (int)std::min(a.x, b.x);
+                int y = (int)std::min(a.y, b.y);
+                int w = (int)std::abs(b.x - a.x);
+                int h = (int)std::abs(b.y - a.y);
+                if (w <= 0 || h <= 0) continue;
+
+                pc.minX = x * scale;
+                pc.minY = y * scale;
+                pc.maxX = (x + w) * scale - 1;
+                pc.maxY = (y + h) * scale - 1;
+                break;
+            }
+            case DrawCommand::Type::CIRCLE: {
+                if (command.pointCount == 0) continue;
+
+                // Outlines are drawn around an integer center, like DrawCircleLines
+                Vector2 c = commandPoints[0];
+                if (!command.filled) {
+                    c = { (float)(int)c.x, (float)(int)c.y };
+                }
+                pc.path.push_back({ c.x * s, c.y * s });
+                pc.radius = command.size * s;
+
+                float extent = pc.radius + s;
+                pc.minX = (int)std::floor(pc.path[0].x - extent);
+                pc.maxX = (int)std::ceil(pc.path[0].x + extent);
+                pc.minY = (int)std::floor(pc.path[0].y - extent);
+                pc.maxY = (int)std::ceil(pc.path[0].y + extent);
+                break;
+            }
+            case DrawCommand::Type::IMAGE: {
+                if (command.image == nullptr) continue;
+
+                pc.maxX = command.image->width * scale - 1;
+                pc.maxY = command.image->height * scale - 1;
+                break;
+            }
+            case DrawCommand::Type::TEXT: {
+                if (command.image == nullptr || command.quads.empty()) continue;
+
+                float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+                for (const auto& quad : command.quads) {
+                    minX = std::min(minX, quad.dest.x);
+                    minY = std::min(minY, quad.dest.y);
+                    maxX = std::max(maxX, quad.dest.x + quad.dest.width);
+                    maxY = std::max(maxY, quad.dest.y + quad.dest.height);
+                }
+                pc.minX = (int)std::floor(minX * s);
+                pc.minY = (int)std::floor(minY * s);
+                pc.maxX = (int)std::ceil(maxX * s);
+                pc.maxY = (int)std::ceil(maxY * s);
+                break;
+            }
+            case DrawCommand::Type::CROP:
+                if (command.pointCount == 0) continue;
+                break;
+            case DrawCommand::Type::CLEAR:
+                break;
+        }
+
+        prepared.push_back(std::move(pc));
+    }
+}
+
+bool TiledExporter::UsesPaletteOnly() const {
+    if (palette.empty() || (int)palette.size() > MAX_INDEXED_COLORS) return false;
+
+    for (size_t i = 0; i < count; i++) {
+        const DrawCommand& command = commands[i];
+        if (command.type == DrawCommand::Type::IMAGE) return false;
+        if (command.type == DrawCommand::Type::CROP) continue;
+
+        if (command.type == DrawCommand::Type::TEXT) {
+            // Glyph texels are white or transparent, so only quad colors appear
+            for (const auto& quad : command.quads) {
+                if (!ContainsColor(palette, quad.color)) return false;
+            }
+            continue;
+        }
+        if (!ContainsColor(palette, command.color)) return false;
+    }
+    return true;
+}
+
+void TiledExporter::RenderTile(int tileX, int tileY, int tileW, int tileH, Color* pixels, int stride) const {
+    // Canvas starts black
+    for (int y = 0; y < tileH; y++) {
+        std::fill(pixels + (size_t)y * stride, pixels + (size_t)y * stride + tileW, BLACK);
+    }
+
+    float s = (float)scale;
+    int tileX1 = tileX + tileW - 1;
+    int tileY1 = tileY + tileH - 1;
+
+    for (const auto& pc : prepared) {
+        if (pc.maxX < tileX || pc.minX > tileX1 || pc.maxY < tileY || pc.minY > tileY1) continue;
+
+        TileTarget t = {
+            pixels, stride, tileX, tileY,
+            std::max(pc.minX, tileX), std::max(pc.minY, tileY),
+            std::min(pc.maxX, tileX1), std::min(pc.maxY, tileY1)
+        };
+        const DrawCommand& command = *pc.command;
+
+        switch (command.type) {
+            case DrawCommand::Type::STROKE: {
+                if (pc.path.size() == 1) {
+                    FillCapsule(t, pc.path[0], pc.path[0], pc.radius, command.color);
+                }
+                for (size_t i = 1; i < pc.path.size(); i++) {
+                    FillCapsule(t, pc.path[i - 1], pc.path[i], pc.radius, command.color);
+                }
+                break;
+            }
+            case DrawCommand::Type::RECTANGLE: {
+                // Outline is one canvas pixel wide, so scale pixels here
+                for (int y = t.y0; y <= t.y1; y++) {
+                    bool edgeRow = y < pc.minY + scale || y > pc.maxY - scale;
+                    for (int x = t.x0; x <= t.x1; x++) {
+                        if (command.filled || edgeRow || x < pc.minX + scale || x > pc.maxX - scale) {
+                            t.At(x, y) = command.color;
+                        }
+                    }
+                }
+                break;
+            }
+            case DrawCommand::Type::CIRCLE: {
+                if (command.filled) {
+                    FillRing(t, pc.path[0], 0.0f, pc.radius, command.color);
+                } else {
+                    FillRing(t, pc.path[0], pc.radius - s / 2.0f, pc.radius + s / 2.0f, command.color);
+                }
+                break;
+            }
+            case DrawCommand::Type::CLEAR: {
+                for (int y = t.y0; y <= t.y1; y++) {
+                    std::fill(&t.At(t.x0, y), &t.At(t.x1, y) + 1, command.color);
+                }
+                break;
+            }
+            case DrawCommand::Type::CROP: {
+                // Content outside the resized canvas was lost
+                Vector2 size = points[command.firstPoint];
+                int cropW = (int)size.x * scale;
+                int cropH = (int)size.y * scale;
+                for (int y = t.y0; y <= t.y1; y++) {
+                    for (int x = t.x0; x <= t.x1; x++) {
+                        if (x >= cropW || y >= cropH) {
+                            t.At(x, y) = BLACK;
+                        }
+                    }
+                }
+                break;
+            }
+            case DrawCommand::Type::IMAGE: {
+                // Nearest sample, blended over the canvas like DrawTexture
+                const Image& image = *command.image;
+                const Color* src = (const Color*)image.data;
+                for (int y = t.y0; y <= t.y1; y++) {
+                    const Color* srcRow = src + (size_t)(y / scale) * image.width;
+                    for (int x = t.x0; x <= t.x1; x++) {
+                        BlendPixel(t.At(x, y), srcRow[x / scale]);
+                    }
+                }
+                break;
+            }
+            case DrawCommand::Type::TEXT: {
+                for (const auto& quad : command.quads) {
+                    FillQuad(t, quad, *command.image, s);
+                }
+                break;
+            }
+        }
+    }
+}
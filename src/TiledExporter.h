@@ -0,0 +1,42 @@
+#pragma once
+
+#include <raylib.h>
+#include <cstddef>
+#include <vector>
+#include "DrawCommand.h"
+
+// Draws recorded commands again at N times the canvas resolution and
+// streams the result into a PNG. Only one band of tiles is in memory at a
+// time, and the tiles of a band are drawn in parallel on the CPU.
+class TiledExporter {
+public:
+    TiledExporter(const DrawCommand* commands, size_t count, const Vector2* points,
+                  int width, int height, const std::vector<Color>& palette);
+
+    bool Export(const char* filename, int scale);
+
+private:
+    // Command geometry scaled to output pixels
+    struct PreparedCommand {
+        const DrawCommand* command;
+        std::vector<Vector2> path; // STROKE: smoothed path, RECTANGLE: corners, CIRCLE: center
+        float radius;
+        int minX, minY, maxX, maxY; // bounds in output pixels, inclusive
+    };
+
+    const DrawCommand* commands;
+    size_t count;
+    const Vector2* points; // indexed by DrawCommand::firstPoint
+    int width;
+    int height;
+    std::vector<Color> palette;
+
+    int scale;
+    std::vector<PreparedCommand> prepared;
+
+    static constexpr int TILE_SIZE = 256;
+
+    void Prepare();
+    bool UsesPaletteOnly() const;
+    void RenderTile(int tileX, int tileY, int tileW, int tileH, Color* pixels, int stride) const;
+};